@@ -0,0 +1,212 @@
+#include "AnytimeSolver.h"
+#include "Solver.h"
+#include <cstdlib>
+#include <fstream>
+#include <queue>
+
+// A search gives up past this many states, since the next one (with a lower weight) would only need more.
+#define MAX_ANYTIME_STATES 20'000'000
+
+AnytimeSolver::AnytimeSolver(Level* level, const PruningProfile& pruning, const char* patternsPath)
+  : _pruning(level, pruning) {
+  _level = level;
+  _patternsPath = patternsPath;
+  _initialState = level->GetState();
+}
+
+Vector<Direction> AnytimeSolver::Solve(double seconds, const char* demPath) {
+  printf("Solving %s (anytime, for up to %g seconds)\n", _level->name, seconds);
+  _demPath = demPath;
+  _start = std::chrono::steady_clock::now();
+  _deadline = _start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(seconds));
+  _patterns = std::make_unique<PatternDatabase>(_level, _patternsPath, _deadline);
+  _lowerBound = _patterns->LowerBound(_initialState);
+
+  // In tenths. 0 is the greedy search, which ignores how long the route is -- it just needs to find one.
+  // We move on to the next weight after each improvement, and the last one keeps going until it has seen everything.
+  const u32 WEIGHTS[] = {0, 50, 30, 20, 15, 10};
+  const s32 WEIGHT_COUNT = sizeof(WEIGHTS) / sizeof(WEIGHTS[0]);
+  for (s32 i=0; i<WEIGHT_COUNT; i++) {
+    SearchResult result = Search(WEIGHTS[i], i == WEIGHT_COUNT - 1);
+    if (result == SearchResult::Stopped) {
+      UpdateLowerBound();
+      Report("Stopped");
+      break;
+    }
+    if (result == SearchResult::Exhausted) {
+      if (_bestSolution.Size() == 0) {
+        // The greedy search saw every state, so there's nothing for the others to find either.
+        printf("Automatic solver could not find a solution.\n");
+      } else if (_patterns->Admissible()) {
+        _lowerBound = _bestSolution.Size();
+        Report("Finished (move-optimal)");
+      } else {
+        // The pattern databases may have overestimated somewhere, and cut off a shorter route, so we can't promise anything.
+        _lowerBound = _bestSolution.Size();
+        Report("Finished (nothing shorter within the pattern databases' bounds)");
+      }
+      break;
+    }
+  }
+
+  _states.clear();
+  _ids.clear();
+  _level->SetState(&_initialState); // Be polite and make sure we restore the original level state
+  return _bestSolution.Copy();
+}
+
+AnytimeSolver::SearchResult AnytimeSolver::Search(u32 weight, bool untilExhausted) {
+  _weight = weight;
+  _states.clear();
+  _ids.clear();
+  _parents.Resize(0);
+  _moves.Resize(0);
+  _depths.Resize(0);
+  _bounds.Resize(0);
+  _waitingByCost.Resize(0);
+
+  std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> waiting;
+  auto wait = [&](u32 id) {
+    u16 depth = _depths[id];
+    u16 cost = depth + _bounds[id];
+    if (_bestSolution.Size() > 0 && cost >= _bestSolution.Size()) return; // Can't beat what we have
+    while (_waitingByCost.Size() <= cost) _waitingByCost.Push(0);
+    _waitingByCost[cost]++;
+    waiting.push(Entry{Priority(_states[id], depth, _bounds[id]), depth, id});
+  };
+
+  _states.push_back(_initialState);
+  _ids[_initialState] = 0;
+  _parents.Push(0);
+  _moves.Push(None);
+  _depths.Push(0);
+  _bounds.Push(_patterns->LowerBound(_initialState));
+  wait(0);
+
+  bool improved = false;
+  while (!waiting.empty()) {
+    if (OutOfTime()) return SearchResult::Stopped;
+    Entry entry = waiting.top();
+    waiting.pop();
+    u16 cost = entry.depth + _bounds[entry.id];
+    _waitingByCost[cost]--;
+    if (entry.depth != _depths[entry.id]) continue; // Stale, we've found a shorter way there since
+    if (_bestSolution.Size() > 0 && cost >= _bestSolution.Size()) continue; // The solution got better since we queued this
+
+    for (Direction dir : {Up, Down, Left, Right}) {
+      State state = _states[entry.id]; // Copied, since the push below may reallocate
+      _level->SetState(&state);
+      if (!_level->Move(dir)) continue;
+      State nextState = _level->GetState();
+      if (!_pruning.Allows(state, nextState)) continue;
+      u16 depth = entry.depth + 1;
+
+      u32 id;
+      auto it = _ids.find(nextState);
+      if (it == _ids.end()) {
+        if (_states.size() >= MAX_ANYTIME_STATES) {
+          printf("Giving up on the search with weight %.1f (too many states).\n", weight / 10.0);
+          return SearchResult::Stopped;
+        }
+        id = (u32)_states.size();
+        _states.push_back(nextState);
+        _ids[nextState] = id;
+        _parents.Push(entry.id);
+        _moves.Push(dir);
+        _depths.Push(depth);
+        _bounds.Push(_level->Won() ? 0 : _patterns->LowerBound(nextState));
+      } else {
+        id = it->second;
+        if (depth >= _depths[id]) continue;
+        _parents[id] = entry.id;
+        _moves[id] = dir;
+        _depths[id] = depth;
+        // The greedy search doesn't care how long the path is, so there's no point expanding it again.
+        if (weight == 0) continue;
+      }
+
+      if (_level->Won()) {
+        if (Improve(id)) improved = true;
+        continue;
+      }
+      wait(id);
+    }
+    if (improved && !untilExhausted) return SearchResult::Improved;
+  }
+  return SearchResult::Exhausted;
+}
+
+u32 AnytimeSolver::Priority(const State& state, u16 depth, u8 bound) const {
+  if (_weight > 0) return depth * 10 + bound * _weight;
+
+  // Greedy: the most cooked sides first, and then the closest sausage which isn't done yet (or the way home, if they all are).
+  // A cooked side is worth a few steps, so that we don't walk off towards another sausage halfway through cooking one.
+  u32 score = Score(const_cast<State*>(&state));
+  u32 distance = 0xFFFF;
+  for (s32 i=0; i<_level->SausageCount(); i++) {
+    Sausage sausage = state.GetSausage(i);
+    if (sausage.z < 0 || sausage.IsFullyCooked()) continue;
+    u32 distance1 = abs(sausage.x1 - state.stephen.x) + abs(sausage.y1 - state.stephen.y);
+    u32 distance2 = abs(sausage.x2 - state.stephen.x) + abs(sausage.y2 - state.stephen.y);
+    if (distance1 < distance) distance = distance1;
+    if (distance2 < distance) distance = distance2;
+  }
+  if (distance == 0xFFFF) {
+    const Stephen& start = _initialState.stephen;
+    distance = abs(start.x - state.stephen.x) + abs(start.y - state.stephen.y) + abs(start.z - state.stephen.z);
+  }
+  return (100 * _level->SausageCount() - score) * 8 + distance;
+}
+
+bool AnytimeSolver::Improve(u32 id) {
+  Vector<Direction> reversed;
+  for (; id != 0; id = _parents[id]) reversed.Push(_moves[id]);
+  Vector<Direction> solution;
+  for (s32 i = reversed.Size() - 1; i >= 0; i--) solution.Push(reversed[i]);
+  if (_bestSolution.Size() > 0 && solution.Size() > _bestSolution.Size()) return false;
+
+  // Replay it for the timing (and to be sure it wins, since the states went through GetState/SetState on the way).
+  u64 millis = 0;
+  if (!Solver::ReplaySolution(_level, _initialState, solution, &millis)) return false;
+  if (solution.Size() == _bestSolution.Size() && millis >= _bestMillis) return false;
+
+  _bestSolution = solution.Copy();
+  _bestMillis = millis;
+  std::ofstream file(_demPath);
+  for (Direction dir : _bestSolution) file << DEM_DIRS[dir] << '\n';
+  file.close();
+  UpdateLowerBound();
+  Report("Improved");
+  return true;
+}
+
+void AnytimeSolver::UpdateLowerBound() {
+  // The greedy search doesn't keep the shortest path to each state, so we can only go by what's waiting once we search by cost.
+  if (_weight == 0) return;
+  u16 bound = _bestSolution.Size();
+  for (s32 cost=0; cost<_waitingByCost.Size() && cost<bound; cost++) {
+    if (_waitingByCost[cost] != 0) {
+      bound = cost;
+      break;
+    }
+  }
+  if (bound > _lowerBound) _lowerBound = bound;
+}
+
+void AnytimeSolver::Report(const char* what) const {
+  double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - _start).count();
+  const char* atLeast = (_patterns->Admissible() ? "at least" : "probably at least");
+  if (_bestSolution.Size() == 0) {
+    printf("[%.1fs] %s: no solution yet, %s %d moves\n", elapsed, what, atLeast, _lowerBound);
+  } else {
+    printf("[%.1fs] %s: %d moves taking %lld.%03lld seconds, %s %d moves, written to %s\n", elapsed, what,
+      _bestSolution.Size(), _bestMillis / 1000, _bestMillis % 1000, atLeast, _lowerBound, _demPath);
+  }
+  fflush(stdout); // So that it shows up while we're still searching, even if stdout is a file
+}
+
+bool AnytimeSolver::OutOfTime() {
+  if (++_expanded < 1024) return false;
+  _expanded = 0;
+  return std::chrono::steady_clock::now() >= _deadline;
+}
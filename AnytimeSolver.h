@@ -0,0 +1,80 @@
+#pragma once
+#include "Level.h"
+#include "PatternDatabase.h"
+#include "Pruning.h"
+#include "WitnessRNG/StdLib.h"
+#include <chrono>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+// A solver for when we want *a* route now, rather than the best route later. Solver has nothing to show until the BFS,
+// the retrograde pass and the timing search have all finished, which can take hours on the bigger levels.
+// This finds a first solution with a greedy best-first search (on Score, then stephen's distance to the next sausage),
+// then looks for shorter ones with weighted A* searches, restarting with a lower weight after each improvement.
+// Every search is bounded by the best solution so far, and the heuristic is the pattern databases' lower bound.
+// Each time the solution improves, it's written out straight away, so it can be practiced while the search goes on.
+//
+// Alongside each solution we report a lower bound on the number of moves: the smallest g + h of anything still waiting
+// to be expanded (which is where any shorter solution has to come from). If a search runs out of things to expand before
+// the deadline, the bound meets the solution. That only makes it move-optimal (for the pruning profile) when the pattern
+// databases are admissible, which is just the one-sausage levels -- otherwise we say it's the best within their bounds.
+// It's never timing-optimal though; that still needs Solver.
+struct AnytimeSolver {
+  AnytimeSolver(Level* level, const PruningProfile& pruning = {}, const char* patternsPath = nullptr);
+
+  // Searches for up to |seconds|, and writes each improved solution to |demPath| as it's found. Returns the best one.
+  Vector<Direction> Solve(double seconds, const char* demPath);
+
+private:
+  enum class SearchResult : u8 {
+    Improved,
+    Exhausted, // Nothing left which could beat the best solution (as far as the pattern databases can tell), or there isn't one
+    Stopped, // Out of time, or memory
+  };
+
+  // Weighted A* with |weight| in tenths, or the greedy search if it's 0. With |untilExhausted|, we keep going after an improvement.
+  SearchResult Search(u32 weight, bool untilExhausted);
+  u32 Priority(const State& state, u16 depth, u8 bound) const;
+  // Records the solution ending at |id| if it's better than what we have, and writes it out. Returns true if it was.
+  bool Improve(u32 id);
+  void UpdateLowerBound();
+  void Report(const char* what) const;
+  bool OutOfTime();
+
+  // A node waiting to be expanded. Ties go to the deeper node, which is closer to a solution (for the same priority).
+  struct Entry {
+    u32 priority;
+    u16 depth;
+    u32 id;
+    bool operator>(const Entry& other) const {
+      if (priority != other.priority) return priority > other.priority;
+      return depth < other.depth;
+    }
+  };
+
+  Level* _level = nullptr;
+  Pruning _pruning;
+  const char* _patternsPath = nullptr;
+  std::unique_ptr<PatternDatabase> _patterns; // Built by Solve, so that it counts against the deadline
+  State _initialState;
+  const char* _demPath = nullptr;
+  std::chrono::steady_clock::time_point _start;
+  std::chrono::steady_clock::time_point _deadline;
+  u32 _expanded = 0; // Since we last looked at the clock
+  u32 _weight = 0; // For the search we're running
+
+  // The search graph, indexed by state ID. Cleared between searches.
+  std::vector<State> _states;
+  std::unordered_map<State, u32> _ids;
+  Vector<u32> _parents;
+  Vector<Direction> _moves;
+  Vector<u16> _depths; // The shortest path to each state we know of, which can get shorter if we find another way there
+  Vector<u8> _bounds; // Pattern database bounds, so that we only look them up once
+  // How many of the nodes waiting to be expanded have each g + h (some may be stale, which only makes the bound lower).
+  Vector<u32> _waitingByCost;
+
+  Vector<Direction> _bestSolution;
+  u64 _bestMillis = (u64)-1;
+  u16 _lowerBound = 0;
+};
@@ -0,0 +1,189 @@
+#include "CompactSolver.h"
+#include "GraphFile.h"
+#include "PageAllocator.h"
+#include "Solver.h"
+#include <cmath>
+#include <vector>
+
+// One in this many fingerprints keeps its full state, for measuring collisions.
+#define SAMPLE_RATE 1024
+
+CompactSolver::CompactSolver(Level* level, const PruningProfile& pruning) : _pruning(level, pruning) {
+  _level = level;
+  _capacity = 0x800000;
+  _fingerprints = (u64*)AllocatePages(_capacity * sizeof(u64));
+}
+
+CompactSolver::~CompactSolver() {
+  FreePages(_fingerprints, _capacity * sizeof(u64));
+}
+
+u64 CompactSolver::Fingerprint(const State& state) const {
+  // Hashed separately from State::Hash, which doesn't need to be nearly as good.
+  u64 hash = 14695981039346656037ull;
+  hash = HashBytes(hash, &state.stephen, sizeof(state.stephen));
+  for (s32 i=0; i<_level->SausageCount(); i++) {
+    Sausage sausage = state.GetSausage(i);
+    hash = HashBytes(hash, &sausage, sizeof(sausage));
+  }
+  // FNV-1a doesn't mix the last few bytes very well, so finish with murmur's finalizer.
+  hash ^= hash >> 33;
+  hash *= 0xff51afd7ed558ccdull;
+  hash ^= hash >> 33;
+  hash *= 0xc4ceb9fe1a85ec53ull;
+  hash ^= hash >> 33;
+
+#if FINGERPRINT_BITS < 64
+  hash &= (1ull << FINGERPRINT_BITS) - 1;
+#endif
+  return hash == 0 ? 1 : hash; // 0 marks an empty slot
+}
+
+bool CompactSolver::Insert(const State& state, u64 fingerprint) {
+  // Multiplying spreads the fingerprint across the table, even if FINGERPRINT_BITS is smaller than the table.
+  bool sampled = ((fingerprint * 0x9e3779b97f4a7c15ull) >> 32) % SAMPLE_RATE == 0;
+  size_t slot = (fingerprint * 0xbf58476d1ce4e5b9ull) >> 16 & (_capacity - 1);
+  while (true) {
+    if (_fingerprints[slot] == fingerprint) {
+      if (sampled) {
+        auto it = _sampledStates.find(fingerprint);
+        if (it != _sampledStates.end() && !(it->second == state)) _observedOmissions++;
+      }
+      return false;
+    }
+    if (_fingerprints[slot] == 0) break;
+    slot = (slot + 1) & (_capacity - 1);
+  }
+
+  _expectedOmissions += (double)_size / pow(2.0, FINGERPRINT_BITS);
+  _fingerprints[slot] = fingerprint;
+  _size++;
+  if (sampled) _sampledStates.emplace(fingerprint, state);
+  if (_size * 2 > _capacity) Grow();
+  return true;
+}
+
+void CompactSolver::Grow() {
+  u64* oldFingerprints = _fingerprints;
+  size_t oldCapacity = _capacity;
+  _capacity *= 2;
+  _fingerprints = (u64*)AllocatePages(_capacity * sizeof(u64));
+
+  for (size_t i=0; i<oldCapacity; i++) {
+    u64 fingerprint = oldFingerprints[i];
+    if (fingerprint == 0) continue;
+    size_t slot = (fingerprint * 0xbf58476d1ce4e5b9ull) >> 16 & (_capacity - 1);
+    while (_fingerprints[slot] != 0) slot = (slot + 1) & (_capacity - 1);
+    _fingerprints[slot] = fingerprint;
+  }
+  FreePages(oldFingerprints, oldCapacity * sizeof(u64));
+}
+
+Vector<Direction> CompactSolver::Solve() {
+  printf("Solving %s (using %d-bit fingerprints)\n", _level->name, FINGERPRINT_BITS);
+  if (_memoryBudget == 0) _memoryBudget = DefaultMemoryBudget();
+
+  State initialState = _level->GetState();
+  Insert(initialState, Fingerprint(initialState));
+  _parents.Push(0);
+  _moves.Push(None);
+
+  // Full states, for the layer we're expanding and the one we're building. Their IDs are stored alongside.
+  std::vector<State> currentLayer = {initialState};
+  std::vector<State> nextLayer;
+  Vector<u32> currentIds;
+  Vector<u32> nextIds;
+  currentIds.Push(0);
+
+  u32 winningId = 0;
+  bool won = _level->Won();
+  bool outOfMemory = false;
+  u16 depth = 0;
+  while (!won && !outOfMemory && currentLayer.size() > 0) {
+    for (size_t i=0; i<currentLayer.size() && !won && !outOfMemory; i++) {
+      for (Direction dir : {Up, Down, Left, Right}) {
+        _level->SetState(&currentLayer[i]);
+        if (!_level->Move(dir)) continue;
+        State nextState = _level->GetState();
+        if (!_pruning.Allows(currentLayer[i], nextState)) continue;
+        if (!Insert(nextState, Fingerprint(nextState))) continue;
+
+        u32 id = _parents.Size();
+        _parents.Push(currentIds[i]);
+        _moves.Push(dir);
+        if (_level->Won()) {
+          // Unlike Solver, we can't look for faster solutions, so there's no reason to finish the layer.
+          winningId = id;
+          won = true;
+          break;
+        }
+        nextLayer.push_back(nextState);
+        nextIds.Push(id);
+
+        // There's no partial result worth keeping here, so just stop as soon as we're over.
+        // State IDs are u32s (and Vector sizes are s32s), so that's a hard limit regardless of the budget.
+        if ((id & 0xFFFF) == 0 && (MemoryUsed(currentLayer.size() + nextLayer.size()) > _memoryBudget || _size > 2'000'000'000)) {
+          outOfMemory = true;
+          break;
+        }
+      }
+    }
+
+    currentLayer.swap(nextLayer);
+    nextLayer.clear();
+    currentIds.Resize(0);
+    for (u32 id : nextIds) currentIds.Push(id);
+    nextIds.Resize(0);
+    depth++;
+    printf("Finished processing depth %d, %zd states seen, %zd to explore\n", depth - 1, _size, currentLayer.size());
+    if (outOfMemory) {
+      printf("Giving up (using %.2f GB of the %.2f GB budget).\n", MemoryUsed(currentLayer.size()) / 1e9, _memoryBudget / 1e9);
+    }
+  }
+
+  _pruning.PrintStats();
+  printf("Expected number of states dropped by fingerprint collisions: %.3g (chance of any: %.3g)\n",
+    _expectedOmissions, 1.0 - exp(-_expectedOmissions));
+  printf("Collisions seen in the sampled states: %lld (so roughly %lld dropped)\n", _observedOmissions, _observedOmissions * SAMPLE_RATE);
+
+  _level->SetState(&initialState); // Be polite and make sure we restore the original level state
+  if (!won) {
+    printf("Automatic solver could not find a solution.\n");
+    return {};
+  }
+
+  Vector<Direction> solution = ReconstructSolution(winningId);
+  printf("Found a solution in %d moves after %zd states\n", solution.Size(), _size);
+  if (!Verify(initialState, solution)) return {};
+  return solution;
+}
+
+size_t CompactSolver::MemoryUsed(size_t layerStates) const {
+  size_t bytes = _capacity * sizeof(u64);
+  bytes += (size_t)_parents.Size() * (sizeof(u32) + sizeof(Direction));
+  bytes += _sampledStates.size() * (sizeof(u64) + sizeof(State) + 3 * sizeof(void*));
+  bytes += layerStates * (sizeof(State) + sizeof(u32));
+  return bytes;
+}
+
+Vector<Direction> CompactSolver::ReconstructSolution(u32 id) {
+  Vector<Direction> reversed;
+  for (; id != 0; id = _parents[id]) reversed.Push(_moves[id]);
+
+  Vector<Direction> solution;
+  for (s32 i = reversed.Size() - 1; i >= 0; i--) solution.Push(reversed[i]);
+  return solution;
+}
+
+bool CompactSolver::Verify(const State& initialState, const Vector<Direction>& solution) {
+  // Every edge we recorded came from a real Level::Move, so collisions can only cost us states (and maybe the shortest path),
+  // not make the path wrong. But the states along it went through GetState/SetState rather than a clean replay, and this is cheap.
+  u64 millis = 0;
+  if (!Solver::ReplaySolution(_level, initialState, solution, &millis)) {
+    printf("Verification failed, the solution does not win the level!\n");
+    return false;
+  }
+  printf("Verified the solution by replaying it.\n");
+  printf("Solution duration: %lld.%03lld seconds\n", millis / 1000, millis % 1000);
+  return true;
+}
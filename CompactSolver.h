@@ -0,0 +1,50 @@
+#pragma once
+#include "Level.h"
+#include "Pruning.h"
+#include "WitnessRNG/StdLib.h"
+#include <unordered_map>
+
+// An alternative to Solver for exploratory runs on levels which are too large to keep every State in memory (i.e. the overworlds).
+// This is hash compaction: the visited set only holds a FINGERPRINT_BITS fingerprint of each state, plus a parent ID and
+// the move which reached it, and the full States are only kept for the layer we're expanding and the one we're building.
+// That's around 20 bytes per state instead of well over 100, but two different states can now share a fingerprint, in which
+// case we think the second one is a duplicate and never explore it. So, we estimate how many states we might have dropped,
+// and replay the solution through Level::Move at the end to make sure it really wins.
+// Without the full graph there's no timing search, so the result is move-optimal but not necessarily the fastest.
+struct CompactSolver {
+  CompactSolver(Level* level, const PruningProfile& pruning = {});
+  ~CompactSolver();
+
+  Vector<Direction> Solve();
+  // The most memory the search may use, in bytes, like Solver::SetMemoryBudget. 0 (the default) means 3/4 of the machine's RAM.
+  inline void SetMemoryBudget(size_t bytes) { _memoryBudget = bytes; }
+
+private:
+  u64 Fingerprint(const State& state) const;
+  // Returns true if |state| (with |fingerprint|) was not already in the set.
+  bool Insert(const State& state, u64 fingerprint);
+  void Grow();
+  Vector<Direction> ReconstructSolution(u32 id);
+  bool Verify(const State& initialState, const Vector<Direction>& solution);
+  // Roughly how many bytes the search takes up: the fingerprints, the parent IDs and moves, the sampled states,
+  // and the two layers of full states (which are passed in, since they're local to Solve).
+  size_t MemoryUsed(size_t layerStates) const;
+
+  Level* _level = nullptr;
+  Pruning _pruning;
+
+  u64* _fingerprints = nullptr; // Open addressing with linear probing, 0 is empty. Positions come from the fingerprint itself.
+  size_t _capacity = 0; // Always a power of 2
+  size_t _size = 0;
+  // Indexed by state ID, which is the order we inserted them in.
+  Vector<u32> _parents;
+  Vector<Direction> _moves;
+  size_t _memoryBudget = 0;
+
+  // Every insert has a (_size / 2^FINGERPRINT_BITS) chance of colliding with an existing fingerprint, so summing those
+  // gives the expected number of states we dropped. To check that estimate, we also keep the full state for a small sample
+  // of fingerprints, and count the collisions we actually see with those.
+  double _expectedOmissions = 0;
+  std::unordered_map<u64, State> _sampledStates;
+  u64 _observedOmissions = 0;
+};
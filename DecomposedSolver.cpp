@@ -0,0 +1,215 @@
+#include "DecomposedSolver.h"
+#include "Solver.h"
+#include <cstdlib>
+#include <unordered_set>
+#include <vector>
+
+// ExploreSausage gives up past this many states, and assumes the sausage could go anywhere.
+#define MAX_EXPLORED_STATES 2'000'000
+
+DecomposedSolver::DecomposedSolver(Level* level, const PruningProfile& pruning) {
+  _level = level;
+  _pruning = pruning;
+}
+
+void DecomposedSolver::GroupLayout(const State& state, u64 inPlay, Sausage* layout) const {
+  for (s32 i=0; i<_level->SausageCount(); i++) {
+    layout[i] = state.GetSausage(i);
+    if (inPlay & (1ull << i)) continue;
+    // Out of play, the same way the overworld retires sausages.
+    layout[i].z = -2;
+    layout[i].flags = Sausage::Flags::FullyCooked;
+  }
+}
+
+bool DecomposedSolver::GroupCooked(u64 group) const {
+  for (s32 i=0; i<_level->SausageCount(); i++) {
+    if ((group & (1ull << i)) && !_level->CurrentSausage(i).IsFullyCooked()) return false;
+  }
+  return true;
+}
+
+bool DecomposedSolver::ExploreSausage(const State& initialState, s32 i, Vector<u8>& cells) {
+  // A sausage can hang half off the edge of the level, so the cells include a border of one all the way around.
+  s32 width = _level->Width() + 2;
+  s32 height = _level->Height() + 2;
+  auto mark = [&](s8 x, s8 y) {
+    s32 cx = x + 1 < 0 ? 0 : (x + 1 >= width ? width - 1 : x + 1);
+    s32 cy = y + 1 < 0 ? 0 : (y + 1 >= height ? height - 1 : y + 1);
+    cells[cy * width + cx] = 1;
+  };
+
+  std::vector<Sausage> layout(_level->SausageCount());
+  GroupLayout(initialState, 1ull << i, &layout[0]);
+  _level->SetState(initialState.stephen, &layout[0]);
+
+  std::vector<State> states = {_level->GetState()};
+  std::unordered_set<State> seen = {states[0]};
+  for (size_t id=0; id<states.size(); id++) {
+    if (states.size() > MAX_EXPLORED_STATES) {
+      printf("Gave up exploring sausage %c on its own after %zd states\n", 'a' + i, states.size());
+      return false;
+    }
+    Sausage sausage = states[id].GetSausage(i);
+    if (sausage.z >= 0) {
+      mark(sausage.x1, sausage.y1);
+      mark(sausage.x2, sausage.y2);
+    }
+
+    for (Direction dir : {Up, Down, Left, Right}) {
+      State state = states[id]; // Copied, since the push below may reallocate
+      _level->SetState(&state);
+      if (!_level->Move(dir)) continue;
+      State nextState = _level->GetState();
+      if (seen.insert(nextState).second) states.push_back(nextState);
+    }
+  }
+  return true;
+}
+
+void DecomposedSolver::FindGroups(const State& initialState) {
+  s32 sausageCount = _level->SausageCount();
+  s32 cellCount = (_level->Width() + 2) * (_level->Height() + 2); // Including the border, see ExploreSausage
+  u64 allSausages = (sausageCount == 64 ? ~0ull : (1ull << sausageCount) - 1);
+
+  // For each cell, a bit for every sausage which can reach it.
+  Vector<u64> reach;
+  reach.Resize(cellCount);
+  for (s32 j=0; j<cellCount; j++) reach[j] = 0;
+  bool anywhere = false;
+  Vector<u8> cells;
+  cells.Resize(cellCount);
+  for (s32 i=0; i<sausageCount; i++) {
+    for (s32 j=0; j<cellCount; j++) cells[j] = 0;
+    if (!ExploreSausage(initialState, i, cells)) anywhere = true;
+    for (s32 j=0; j<cellCount; j++) {
+      if (cells[j]) reach[j] |= (1ull << i);
+    }
+  }
+  _level->SetState(&initialState);
+
+  // Start with every sausage in its own group, then merge any groups which share a cell.
+  _groups.Resize(0);
+  for (s32 i=0; i<sausageCount; i++) _groups.Push(1ull << i);
+  auto merge = [this](u64 sausages) {
+    u64 merged = 0;
+    for (s32 g=0; g<_groups.Size(); ) {
+      if (_groups[g] & sausages) {
+        merged |= _groups[g];
+        _groups[g] = _groups[_groups.Size() - 1];
+        _groups.Pop();
+      } else {
+        g++;
+      }
+    }
+    if (merged != 0) _groups.Push(merged);
+  };
+  if (anywhere) merge(allSausages);
+  for (s32 j=0; j<cellCount; j++) {
+    if (reach[j] != 0) merge(reach[j]);
+  }
+
+  for (s32 g=0; g<_groups.Size(); g++) {
+    printf("Group %d: sausages ", g);
+    for (s32 i=0; i<sausageCount; i++) {
+      if (_groups[g] & (1ull << i)) putchar('a' + i);
+    }
+    putchar('\n');
+  }
+}
+
+bool DecomposedSolver::SolveGroup(u64 group, u64 solved, bool last, Vector<Direction>& solution) {
+  State state = _level->GetState();
+  std::vector<Sausage> layout(_level->SausageCount());
+  // The groups we already solved stay in play. They're cooked, so they won't add much to the search, but they still get in
+  // stephen's way (and his fork's), which the route needs to respect.
+  GroupLayout(state, group | solved, &layout[0]);
+  _level->SetState(state.stephen, &layout[0]);
+
+  Vector<Direction> moves;
+  {
+    Solver solver(_level, _pruning);
+    moves = solver.Solve();
+  }
+
+  // Replay the moves until the group is cooked. The solver also walked back to the start afterwards, which only the last
+  // group needs to do -- everyone else carries on to the next group from here.
+  _level->SetState(state.stephen, &layout[0]);
+  s32 used = 0;
+  bool done = last ? _level->Won() : GroupCooked(group);
+  while (!done && used < moves.Size()) {
+    if (!_level->Move(moves[used])) break;
+    used++;
+    done = last ? _level->Won() : GroupCooked(group);
+  }
+  if (!done) {
+    printf("Could not solve the group on its own\n");
+    return false;
+  }
+  for (s32 j=0; j<used; j++) solution.Push(moves[j]);
+
+  // Bring back the other groups, as they were before.
+  State end = _level->GetState();
+  for (s32 i=0; i<_level->SausageCount(); i++) {
+    layout[i] = ((group | solved) & (1ull << i)) ? end.GetSausage(i) : state.GetSausage(i);
+  }
+  _level->SetState(end.stephen, &layout[0]);
+  return true;
+}
+
+Vector<Direction> DecomposedSolver::Solve() {
+  printf("Solving %s (split into independent groups of sausages)\n", _level->name);
+
+  State initialState = _level->GetState();
+  FindGroups(initialState);
+
+  if (_groups.Size() > 1) {
+    Vector<Direction> solution;
+    Vector<u64> remaining = _groups.Copy();
+    u64 solved = 0;
+    bool ok = true;
+    while (remaining.Size() > 0 && ok) {
+      // Nearest group first, by the distance from stephen to its closest sausage.
+      const Stephen& stephen = _level->CurrentStephen();
+      s32 nearest = 0;
+      s32 nearestDistance = 0x7FFFFFFF;
+      for (s32 g=0; g<remaining.Size(); g++) {
+        for (s32 i=0; i<_level->SausageCount(); i++) {
+          if (!(remaining[g] & (1ull << i))) continue;
+          const Sausage& sausage = _level->CurrentSausage(i);
+          s32 distance = abs(sausage.x1 - stephen.x) + abs(sausage.y1 - stephen.y);
+          if (distance < nearestDistance) {
+            nearest = g;
+            nearestDistance = distance;
+          }
+        }
+      }
+      u64 group = remaining[nearest];
+      remaining[nearest] = remaining[remaining.Size() - 1];
+      remaining.Pop();
+      ok = SolveGroup(group, solved, remaining.Size() == 0, solution);
+      solved |= group;
+    }
+
+    if (ok && Verify(initialState, solution)) return solution;
+    printf("The groups could not be solved separately, solving the level as a whole instead.\n");
+    _level->SetState(&initialState);
+  } else {
+    printf("Every sausage can reach every other, so the level can't be split up.\n");
+  }
+
+  Solver solver(_level, _pruning);
+  return solver.Solve();
+}
+
+bool DecomposedSolver::Verify(const State& initialState, const Vector<Direction>& solution) {
+  // The groups were solved with each other out of play, so make sure the combined route really wins with everything present.
+  u64 millis = 0;
+  if (!Solver::ReplaySolution(_level, initialState, solution, &millis)) {
+    printf("The combined route does not win the level!\n");
+    return false;
+  }
+  printf("Combined the groups into a solution of %d moves, and verified it by replaying it.\n", solution.Size());
+  printf("Solution duration: %lld.%03lld seconds\n", millis / 1000, millis % 1000);
+  return true;
+}
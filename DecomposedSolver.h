@@ -0,0 +1,42 @@
+#pragma once
+#include "Level.h"
+#include "Pruning.h"
+#include "WitnessRNG/StdLib.h"
+
+// A wrapper around Solver for levels where the sausages split into groups which never touch each other.
+// Searching them together explores every combination of every group's positions, but if the groups are independent,
+// we can solve each group on its own (with the groups we haven't got to yet out of play) and then play the routes one after another.
+// That turns the size of the search into a sum over the groups instead of a product.
+//
+// To find the groups, we explore each sausage on its own (with every other sausage removed, like PatternDatabase does),
+// and record every cell it can ever reach. Two sausages whose cells never overlap can't push, block, or carry each other.
+// Caveat: this has the same hole as the pattern databases -- another sausage can still act as a bridge for stephen, which
+// lets him reach a sausage from a side we never saw. So the combined route is always replayed on the real level, and if it
+// doesn't win, we fall back to solving the level as a whole.
+//
+// Each group's route is cut off as soon as that group is cooked, and the next group starts from wherever stephen ended up,
+// so the walk between groups is part of the next group's search. Only the last group walks back to the start.
+// The groups we've already solved stay in play after that, since they still block stephen on his way past.
+// The result wins, but it isn't necessarily optimal -- the order we do the groups in (nearest first) is a guess.
+struct DecomposedSolver {
+  DecomposedSolver(Level* level, const PruningProfile& pruning = {});
+
+  Vector<Direction> Solve();
+
+private:
+  // Fills _groups, as bitmasks of sausage numbers.
+  void FindGroups(const State& initialState);
+  // Marks every cell which sausage |i| can reach from |initialState| on its own. Returns false if we gave up.
+  bool ExploreSausage(const State& initialState, s32 i, Vector<u8>& cells);
+  // The sausages in |inPlay| where they are in |state|, and every other sausage out of play.
+  void GroupLayout(const State& state, u64 inPlay, Sausage* layout) const;
+  bool GroupCooked(u64 group) const;
+  // Solves |group| starting from the level's current state (alongside the groups in |solved|), and appends its moves to
+  // |solution|. Returns false if it couldn't.
+  bool SolveGroup(u64 group, u64 solved, bool last, Vector<Direction>& solution);
+  bool Verify(const State& initialState, const Vector<Direction>& solution);
+
+  Level* _level = nullptr;
+  PruningProfile _pruning;
+  Vector<u64> _groups;
+};
@@ -0,0 +1,285 @@
+#include "EngineChecker.h"
+#include <chrono>
+#include <cstring>
+#include <unordered_set>
+
+// The order that the sweep tries moves in, so that we can turn a step back into a move.
+const Direction DIRECTIONS[] = {Up, Down, Left, Right};
+
+bool LevelEngine::Move(Direction dir) {
+  if (_roundTrip) {
+    State state = _level->GetState();
+    _level->SetState(&state);
+  }
+  return _level->Move(dir);
+}
+
+EngineChecker::EngineChecker(Level** levels, s32 levelCount) {
+  _levels = levels;
+  _levelCount = levelCount;
+}
+
+s32 EngineChecker::Run(MoveEngine& reference, MoveEngine& candidate) {
+  printf("Checking %s against %s\n", candidate.Name(), reference.Name());
+  _random.seed(seed);
+
+  s32 mismatches = 0;
+  double referenceSeconds = 0;
+  double candidateSeconds = 0;
+  u64 totalMoves = 0;
+  for (s32 i=0; i<_levelCount; i++) {
+    Level* level = _levels[i];
+    if (!Fits(level)) continue;
+    _sausageCount = level->SausageCount();
+    State initialState = level->GetState();
+
+    reference.Load(level);
+    candidate.Load(level);
+
+    Sweep sweep;
+    BuildSweep(reference, initialState, sweep);
+    Trace referenceTrace;
+    Trace candidateTrace;
+    RunSweep(reference, sweep, referenceTrace);
+    RunSweep(candidate, sweep, candidateTrace);
+    s64 step = FirstMismatch(referenceTrace, candidateTrace);
+    if (step >= 0) {
+      // Turn the sweep step back into a walk from the initial state
+      std::vector<Direction> walk = {DIRECTIONS[step % 4]};
+      for (u32 id = (u32)(step / 4); id != 0; id = sweep.parents[id]) walk.insert(walk.begin(), sweep.moves[id]);
+      printf("%s: %s and %s disagree in the sweep\n", level->name, reference.Name(), candidate.Name());
+      ReportMismatch(reference, candidate, initialState, walk);
+      mismatches++;
+      level->SetState(&initialState);
+      continue;
+    }
+    double levelReference = referenceTrace.seconds;
+    double levelCandidate = candidateTrace.seconds;
+    u64 levelMoves = sweep.states.size() * 4;
+
+    bool matched = true;
+    std::vector<Direction> walk(walkLength);
+    for (u32 j=0; j<walks && matched; j++) {
+      for (Direction& dir : walk) dir = DIRECTIONS[_random() % 4];
+      Trace referenceWalk;
+      Trace candidateWalk;
+      RunWalk(reference, initialState, walk, referenceWalk);
+      RunWalk(candidate, initialState, walk, candidateWalk);
+      step = FirstMismatch(referenceWalk, candidateWalk);
+      if (step >= 0) {
+        printf("%s: %s and %s disagree on random walk %d\n", level->name, reference.Name(), candidate.Name(), j);
+        walk.resize(step + 1);
+        ReportMismatch(reference, candidate, initialState, walk);
+        matched = false;
+      }
+      levelReference += referenceWalk.seconds;
+      levelCandidate += candidateWalk.seconds;
+      levelMoves += walkLength;
+    }
+    level->SetState(&initialState); // Be polite and make sure we restore the original level state
+    if (!matched) {
+      mismatches++;
+      continue;
+    }
+
+    printf("%s: %lld moves match, %s %.1fM moves/s, %s %.1fM moves/s\n", level->name, levelMoves,
+      reference.Name(), levelMoves / levelReference / 1e6, candidate.Name(), levelMoves / levelCandidate / 1e6);
+    referenceSeconds += levelReference;
+    candidateSeconds += levelCandidate;
+    totalMoves += levelMoves;
+  }
+
+  if (totalMoves > 0) {
+    printf("Overall: %s %.1fM moves/s, %s %.1fM moves/s (%.2fx)\n", reference.Name(), totalMoves / referenceSeconds / 1e6,
+      candidate.Name(), totalMoves / candidateSeconds / 1e6, referenceSeconds / candidateSeconds);
+  }
+  printf("%d levels had mismatches\n", mismatches);
+  return mismatches;
+}
+
+void EngineChecker::Benchmark(MoveEngine& engine, u32 repeats) {
+  printf("Benchmarking %s (best of %d runs)\n", engine.Name(), repeats);
+  double totalSeconds = 0;
+  u64 totalMoves = 0;
+  for (s32 i=0; i<_levelCount; i++) {
+    Level* level = _levels[i];
+    if (!Fits(level)) continue;
+    State initialState = level->GetState();
+
+    engine.Load(level);
+    Sweep sweep;
+    BuildSweep(engine, initialState, sweep);
+    // Same moves as the sweep in Run, but without recording anything, so it's just the engine being timed.
+    // The fastest run is the one with the least interference from everything else on the machine.
+    double best = 0;
+    u32 won = 0;
+    for (u32 j=0; j<repeats; j++) {
+      auto start = std::chrono::high_resolution_clock::now();
+      for (const State& state : sweep.states) {
+        for (Direction dir : DIRECTIONS) {
+          engine.SetState(&state);
+          if (engine.Move(dir) && engine.Won()) won++; // So that the compiler can't skip the moves
+        }
+      }
+      double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+      if (j == 0 || seconds < best) best = seconds;
+    }
+    level->SetState(&initialState); // Be polite and make sure we restore the original level state
+
+    u64 levelMoves = sweep.states.size() * 4;
+    printf("%s: %.1fM moves/s (%d sausages, %lld moves, %d wins)\n", level->name, levelMoves / best / 1e6,
+      level->SausageCount(), levelMoves, won / repeats);
+    totalSeconds += best;
+    totalMoves += levelMoves;
+  }
+  if (totalMoves > 0) printf("Overall: %.1fM moves/s\n", totalMoves / totalSeconds / 1e6);
+}
+
+bool EngineChecker::Fits(Level* level) const {
+#if !OVERWORLD_HACK
+#define o(x) +1
+  if (level->SausageCount() != SAUSAGES) return false; // The level doesn't fit into State
+#undef o
+#endif
+  // Otherwise the level failed to load. We can't ask GetState, since with OVERWORLD_HACK it reads the initial sausages,
+  // which a level that gave up on loading never set.
+  return level->CurrentStephen().x >= 0;
+}
+
+void EngineChecker::BuildSweep(MoveEngine& engine, const State& initialState, Sweep& sweep) {
+  std::unordered_set<State> seen;
+  sweep.states.push_back(initialState);
+  sweep.parents.push_back(0);
+  sweep.moves.push_back(None);
+  seen.insert(initialState);
+  for (u32 id=0; id<sweep.states.size() && sweep.states.size() < sweepStates; id++) {
+    for (Direction dir : DIRECTIONS) {
+      State state = sweep.states[id]; // Copied, since the push below may reallocate
+      engine.SetState(&state);
+      if (!engine.Move(dir)) continue;
+      State nextState = engine.GetState();
+      if (!seen.insert(nextState).second) continue;
+      sweep.states.push_back(nextState);
+      sweep.parents.push_back(id);
+      sweep.moves.push_back(dir);
+    }
+  }
+}
+
+void EngineChecker::RunSweep(MoveEngine& engine, const Sweep& sweep, Trace& trace) {
+  trace.words.reserve(sweep.states.size() * 4 * StepWords());
+  auto start = std::chrono::high_resolution_clock::now();
+  for (const State& state : sweep.states) {
+    for (Direction dir : DIRECTIONS) {
+      engine.SetState(&state);
+      Record(engine, engine.Move(dir), trace);
+    }
+  }
+  trace.seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+void EngineChecker::RunWalk(MoveEngine& engine, const State& initialState, const std::vector<Direction>& walk, Trace& trace) {
+  trace.words.reserve(walk.size() * StepWords());
+  auto start = std::chrono::high_resolution_clock::now();
+  engine.SetState(&initialState);
+  State state = initialState;
+  for (Direction dir : walk) {
+    bool moved = engine.Move(dir);
+    Record(engine, moved, trace);
+    if (moved) {
+      state = engine.GetState();
+    } else {
+      engine.SetState(&state); // Useless moves can leave the engine anywhere, so put it back
+    }
+  }
+  trace.seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+void EngineChecker::Record(MoveEngine& engine, bool moved, Trace& trace) {
+  if (!moved) {
+    trace.words.insert(trace.words.end(), StepWords(), 0);
+    return;
+  }
+  State state = engine.GetState();
+  trace.words.push_back(1 | (engine.Won() ? 2 : 0));
+  u64 word;
+  memcpy(&word, &state.stephen, sizeof(word));
+  trace.words.push_back(word);
+  for (s32 i=0; i<_sausageCount; i++) {
+    Sausage sausage = state.GetSausage(i);
+    memcpy(&word, &sausage, sizeof(word));
+    trace.words.push_back(word);
+  }
+}
+
+s64 EngineChecker::FirstMismatch(const Trace& a, const Trace& b) const {
+  size_t size = a.words.size() < b.words.size() ? a.words.size() : b.words.size();
+  for (size_t i=0; i<size; i++) {
+    if (a.words[i] != b.words[i]) return (s64)(i / StepWords());
+  }
+  if (a.words.size() != b.words.size()) return (s64)(size / StepWords());
+  return -1;
+}
+
+bool EngineChecker::WalkMismatches(MoveEngine& reference, MoveEngine& candidate, const State& initialState, const std::vector<Direction>& walk, s64* step) {
+  Trace referenceTrace;
+  Trace candidateTrace;
+  RunWalk(reference, initialState, walk, referenceTrace);
+  RunWalk(candidate, initialState, walk, candidateTrace);
+  s64 mismatch = FirstMismatch(referenceTrace, candidateTrace);
+  if (step != nullptr) *step = mismatch;
+  return mismatch >= 0;
+}
+
+void EngineChecker::ReportMismatch(MoveEngine& reference, MoveEngine& candidate, const State& initialState, std::vector<Direction> walk) {
+  s64 step;
+  if (!WalkMismatches(reference, candidate, initialState, walk, &step)) {
+    // e.g. the candidate only goes wrong after a SetState, so the walk doesn't reproduce it. Report it as-is.
+    printf("  (could not reproduce this as a walk from the initial state, so it has not been shrunk)\n");
+  } else {
+    // Delta debugging: try cutting out chunks of moves, and keep any cut which still disagrees.
+    walk.resize(step + 1);
+    for (size_t chunk = walk.size() / 2; chunk >= 1; chunk /= 2) {
+      for (size_t start = 0; start + chunk <= walk.size() && walk.size() > 1; ) {
+        std::vector<Direction> shorter(walk.begin(), walk.begin() + start);
+        shorter.insert(shorter.end(), walk.begin() + start + chunk, walk.end());
+        if (WalkMismatches(reference, candidate, initialState, shorter, &step)) {
+          shorter.resize(step + 1);
+          walk = shorter;
+        } else {
+          start++;
+        }
+      }
+    }
+  }
+
+  const char* DIRS = " ULJCRD";
+  printf("  Moves from the initial state: ");
+  for (Direction dir : walk) putchar(DIRS[dir]);
+  printf(" (%zd moves)\n", walk.size());
+
+  // Show what each engine did on the last move.
+  for (MoveEngine* engine : {&reference, &candidate}) {
+    // Same as RunWalk, but we only care about the last move.
+    State state = initialState;
+    engine->SetState(&state);
+    bool moved = true;
+    for (size_t i=0; i<walk.size(); i++) {
+      if (!moved) engine->SetState(&state);
+      moved = engine->Move(walk[i]);
+      if (moved) state = engine->GetState();
+    }
+    // Raw words as well, since the difference might be in bytes which don't have a name (i.e. padding).
+    u64 word;
+    memcpy(&word, &state.stephen, sizeof(word));
+    printf("  %s: %s%s, stephen at (%d, %d, %d) facing %d, fork at (%d, %d, %d) facing %d [%016llx]\n", engine->Name(),
+      moved ? "moved" : "useless move", moved && engine->Won() ? " (won)" : "", state.stephen.x, state.stephen.y, state.stephen.z,
+      state.stephen.dir, state.stephen.forkX, state.stephen.forkY, state.stephen.forkZ, state.stephen.forkDir, word);
+    for (s32 i=0; i<_sausageCount; i++) {
+      Sausage sausage = state.GetSausage(i);
+      memcpy(&word, &sausage, sizeof(word));
+      printf("    sausage %d at (%d, %d)-(%d, %d, %d) flags %02x [%016llx]\n", i, sausage.x1, sausage.y1, sausage.x2, sausage.y2,
+        sausage.z, sausage.flags, word);
+    }
+  }
+}
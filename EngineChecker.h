@@ -0,0 +1,85 @@
+#pragma once
+#include "Level.h"
+#include <random>
+#include <vector>
+
+// The interface which EngineChecker drives. Level is the reference implementation; a faster engine only needs to provide these.
+struct MoveEngine {
+  virtual ~MoveEngine() = default;
+  virtual const char* Name() const = 0;
+  // Called before checking each level. The engine starts in the level's current state.
+  virtual void Load(Level* level) = 0;
+  virtual void SetState(const State* state) = 0;
+  // Same contract as Level::Move. After a useless move the engine's state is undefined, and the checker will SetState.
+  virtual bool Move(Direction dir) = 0;
+  virtual State GetState() const = 0;
+  virtual bool Won() const = 0;
+};
+
+// Level::Move itself. With |roundTrip|, every move starts by saving and restoring the state, which is what Solver does
+// between moves. Comparing that against a plain Level catches anything which Level remembers that State doesn't.
+struct LevelEngine : public MoveEngine {
+  LevelEngine(bool roundTrip) : _roundTrip(roundTrip) {}
+  const char* Name() const override { return _roundTrip ? "round-trip" : "reference"; }
+  void Load(Level* level) override { _level = level; }
+  void SetState(const State* state) override { _level->SetState(state); }
+  bool Move(Direction dir) override;
+  State GetState() const override { return _level->GetState(); }
+  bool Won() const override { return _level->Won(); }
+
+private:
+  Level* _level = nullptr;
+  bool _roundTrip;
+};
+
+// Runs two engines over the same moves on every level, and compares the results bit for bit.
+// There are two kinds of scripts: a BFS sweep, which tries every move from every state (up to a limit) starting from a
+// SetState, and random walks, which keep moving from wherever the last move left the engine.
+// Any mismatch is shrunk down to a short sequence of moves from the level's initial state which still reproduces it.
+struct EngineChecker {
+  EngineChecker(Level** levels, s32 levelCount);
+
+  u32 sweepStates = 20'000; // Per level
+  u32 walks = 200; // Per level
+  u32 walkLength = 200;
+  u64 seed = 1;
+
+  // Returns the number of levels where the engines disagreed.
+  s32 Run(MoveEngine& reference, MoveEngine& candidate);
+  // Times just |engine| over each level's sweep (the best of |repeats| runs), for comparing changes to an engine.
+  // Only the levels with SAUSAGES sausages are run, so e.g. the Great Tower (4 sausages) needs a build with o(3) added.
+  void Benchmark(MoveEngine& engine, u32 repeats);
+
+private:
+  // The result of each move in a script, flattened: whether the move worked, whether the level was won,
+  // then stephen and each sausage (as raw u64s, so that padding bytes count too).
+  struct Trace {
+    std::vector<u64> words;
+    double seconds = 0;
+  };
+
+  struct Sweep {
+    std::vector<State> states; // In BFS order, states[0] is the initial state
+    std::vector<u32> parents;
+    std::vector<Direction> moves; // The move from the parent
+  };
+
+  // Whether |level| loaded, and fits into State.
+  bool Fits(Level* level) const;
+  void BuildSweep(MoveEngine& engine, const State& initialState, Sweep& sweep);
+  void RunSweep(MoveEngine& engine, const Sweep& sweep, Trace& trace);
+  void RunWalk(MoveEngine& engine, const State& initialState, const std::vector<Direction>& walk, Trace& trace);
+  void Record(MoveEngine& engine, bool moved, Trace& trace);
+  inline size_t StepWords() const { return 2 + _sausageCount; }
+  // Returns the first step where the traces differ, or -1 if they match.
+  s64 FirstMismatch(const Trace& a, const Trace& b) const;
+
+  // Shrinks a walk which makes the engines disagree, and prints it.
+  void ReportMismatch(MoveEngine& reference, MoveEngine& candidate, const State& initialState, std::vector<Direction> walk);
+  bool WalkMismatches(MoveEngine& reference, MoveEngine& candidate, const State& initialState, const std::vector<Direction>& walk, s64* step = nullptr);
+
+  Level** _levels;
+  s32 _levelCount;
+  s32 _sausageCount = 0; // For the level we're currently checking
+  std::mt19937_64 _random;
+};
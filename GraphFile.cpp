@@ -0,0 +1,57 @@
+#include "GraphFile.h"
+#if _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if _WIN32
+MappedFile::MappedFile(const char* path) {
+  _file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (_file == INVALID_HANDLE_VALUE) {
+    _file = nullptr;
+    return;
+  }
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(_file, &size) || size.QuadPart == 0) return;
+  _mapping = CreateFileMappingA(_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (_mapping == nullptr) return;
+  _data = (const u8*)MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0);
+  if (_data != nullptr) _size = size.QuadPart;
+}
+
+MappedFile::~MappedFile() {
+  if (_data != nullptr) UnmapViewOfFile(_data);
+  if (_mapping != nullptr) CloseHandle(_mapping);
+  if (_file != nullptr) CloseHandle(_file);
+}
+#else
+MappedFile::MappedFile(const char* path) {
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) return;
+  struct stat info;
+  if (fstat(fd, &info) == 0 && info.st_size > 0) {
+    void* data = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data != MAP_FAILED) {
+      _data = (const u8*)data;
+      _size = info.st_size;
+    }
+  }
+  close(fd); // The mapping stays valid without the file descriptor
+}
+
+MappedFile::~MappedFile() {
+  if (_data != nullptr) munmap((void*)_data, _size);
+}
+#endif
+
+u64 HashBytes(u64 hash, const void* bytes, size_t length) {
+  for (size_t i=0; i<length; i++) {
+    hash ^= ((const u8*)bytes)[i];
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include "LevelData.h"
+#include "WitnessRNG/StdLib.h"
+
+// Bump this whenever the engine (Level::Move and friends) changes behavior, so that old graph files get rejected.
+#define ENGINE_VERSION 1
+
+// Solver can save its explored graph after the BFS, and load it in later runs to skip straight to ComputeWinningStates.
+// The file is laid out as:
+//   GraphFileHeader
+//   GraphFileNode[nodeCount]                   Node IDs match Solver::_explored, so node 0 is the initial state.
+//   (Stephen, Sausage[sausageCount])[nodeCount] Packed, since the overworld states are variable-size in memory.
+struct GraphFileHeader {
+  char magic[4];
+  u32 engineVersion;
+  u64 key; // Identifies the level, the starting state, and the pruning profile the graph was built from
+  u32 nodeSize; // sizeof(GraphFileNode), which changes with PARENT_POINTERS
+  u32 sausageCount;
+  u32 nodeCount;
+  u16 winningDepth;
+  u16 expandedDepth; // Only meaningful with PARENT_POINTERS
+};
+
+#define NO_NODE 0xFFFFFFFF
+struct GraphFileNode {
+#if PARENT_POINTERS
+  u32 parent;
+  u16 depth;
+  Direction move;
+#else
+  u32 children[4]; // Up, Down, Left, Right, or NO_NODE if the move was illegal (or pruned)
+#endif
+  u16 winDistance;
+};
+
+// A read-only memory mapping of an entire file. Data() is nullptr if the file couldn't be opened.
+class MappedFile {
+public:
+  MappedFile(const char* path);
+  ~MappedFile();
+  inline const u8* Data() const { return _data; }
+  inline size_t Size() const { return _size; }
+
+private:
+  const u8* _data = nullptr;
+  size_t _size = 0;
+#if _WIN32
+  void* _file = nullptr;
+  void* _mapping = nullptr;
+#endif
+};
+
+// FNV-1a, for building graph keys.
+u64 HashBytes(u64 hash, const void* bytes, size_t length);
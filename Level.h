@@ -1,77 +1,106 @@
-#pragma once
-#include "LevelData.h"
-#include "State.h"
-#include "WitnessRNG/StdLib.h"
-
-struct Level : public LevelData {
-  using LevelData::LevelData; // Inherit the constructor
-
-  // The starting point whenever you write an automated solver -- this function allows the user to
-  // manually input the moves they'd like to make. This also is a critical debugging tool, since it
-  // allows us to reproduce a specific behavior.
-  bool InteractiveSolver();
-
-  // Serialize/deserialize the current state, used for backtracking algorithms.
-  State GetState() const;
-  void SetState(const State* state);
-
-  // The main entry point -- this takes a player input (any of the 4 cardinal directions) and
-  // simulates the game's behavior by moving stephen, his fork, and the sausages around the level.
-  // This function returns false if moves is "useless", i.e. it would cause an immediate loss
-  // or zero change in state (walking into a wall).
-  bool Move(Direction dir);
-private:
-  // These 4 functions handle the different ways stephen can move on level terrain
-  // Much like the parent Move function, their return value indicates a useless move.
-  bool HandleLogRolling(Direction dir, bool& handled);
-  bool HandleLadderMotion(Direction dir, bool& handled);
-  bool HandleRotation(Direction dir, bool& handled);
-  bool HandleBurnedStep(Direction dir, bool& handled);
-  bool HandleForkReconnect(Direction dir, bool& handled);
-  // TODO: Rename, repurposed
-  bool MoveThroughSpace3(Direction dir, s8 stephenRotationDir=0);
-
-  // This function checks if *whatever* is at |x, y, z| can move in a direction |dir|
-  // For example, air can always move, walls can never move, and most everything else
-  // will check the cell in front of it.
-  // This function has no direct side-effects, but does evaluate the entirety of the movement,
-  // and updates the below struct with the potential results of the call.
-  struct CPMData {
-    Vector<s8> movedSausages;
-    Vector<s8> sausagesToRoll;
-    Vector<s8> sausagesToDrop;
-    s8 sausageToSpear = -1; // This applies to *all* situations where a fork gets stuck in a sausage.
-    s8 sausageHat = -1;
-    u8 consideredSausages = 0; // We have /considered/ if this sausage can physically move and added it to movedSausages if applicable
-    u8 sausagesToDoubleMove = 0;
-    bool pushedFork = false;
-    bool canPhysicallyMove = false;
-  } data;
-  bool Consider(s8 sausageNo); // Helper around data.consideredSausages
-  bool CanPhysicallyMove(s8 x, s8 y, s8 z, Direction dir, bool stephenIsRotating=false);
-  // Recursive internal function which actually does the heavy lifting.
-  bool CanPhysicallyMoveInternal(s8 x, s8 y, s8 z, Direction dir);
-  // Another internal helper because sausage carrying is complicated
-  bool IsSausageCarried(s8 x, s8 y, s8 z, Direction dir, bool stephenIsRotating, bool canDoubleMove);
-  void CheckForSausageCarry(s8 x, s8 y, s8 z, Direction dir, bool stephenIsRotating);
-
-  // The counterpart to CanPhysicallyMove, MoveThroughSpace actually enacts the proposed movement.
-  // Note that in some cases a move will have side effects but not result in stephen moving.
-  // As with CPM, a return value of false indicates a useless movement.
-  bool MoveThroughSpace(s8 x, s8 y, s8 z, Direction dir, s8 stephenRotationDir=0, bool checkSausageCarry=false, bool doSausageRotation=false, bool doDoubleMove=true);
-  bool MoveThroughSpaceInternal(s8 x, s8 y, s8 z, Direction dir, s8 stephenRotationDir=0, bool doSausageRotation=false, bool doDoubleMove=true);
-
-  // This function handles movement of stephen (and his fork) common to all the above functions.
-  // A return value of false indicates a useless move.
-  bool MoveStephenThroughSpace(Direction dir, bool ladderMotion=false);
-
-  // Saves which sausage the fork is currently stuck in (-1 if not stuck).
-  // *technically* this should live on Stephen, but it would make that > sizeof(u64).
-  s8 _sausageSpeared = -1;
-  bool _interactive = false; // Set to true while in the InteractiveSolver, allows us to emit nice errors
-
-  inline Direction Inverse(Direction dir) {
-    assert(dir > 0 && dir < 7);
-    return (Direction)(7 - dir);
-  }
-};
+#pragma once
+#include "LevelData.h"
+#include "State.h"
+#include "WitnessRNG/StdLib.h"
+
+struct Level : public LevelData {
+  using LevelData::LevelData; // Inherit the constructor
+
+  // The starting point whenever you write an automated solver -- this function allows the user to
+  // manually input the moves they'd like to make. This also is a critical debugging tool, since it
+  // allows us to reproduce a specific behavior.
+  bool InteractiveSolver();
+
+  // Serialize/deserialize the current state, used for backtracking algorithms.
+  State GetState() const;
+  void SetState(const State* state);
+  // Same as above, but from every sausage's position rather than a State (whose layout depends on OVERWORLD_HACK).
+  void SetState(const Stephen& stephen, const Sausage* sausages);
+  // GetState().Hash() and GetState() == state, but (usually) without building a State.
+  size_t Hash() const;
+  bool Matches(const State& state) const;
+
+  // The main entry point -- this takes a player input (any of the 4 cardinal directions) and
+  // simulates the game's behavior by moving stephen, his fork, and the sausages around the level.
+  // This function returns false if moves is "useless", i.e. it would cause an immediate loss
+  // or zero change in state (walking into a wall).
+  bool Move(Direction dir);
+private:
+  // Move is made of these two halves, so that a bounce off a grill can make another move in between them.
+  // StartMove moves stephen (and anything he pushes), FinishMove handles the things which happen after every move.
+  bool StartMove(Direction dir);
+  bool FinishMove(Direction dir);
+  // These 4 functions handle the different ways stephen can move on level terrain
+  // Much like the parent Move function, their return value indicates a useless move.
+  bool HandleLogRolling(Direction dir, bool& handled);
+  bool HandleLadderMotion(Direction dir, bool& handled);
+  bool HandleRotation(Direction dir, bool& handled);
+  bool HandleForkReconnect(Direction dir, bool& handled);
+  // TODO: Rename, repurposed
+  bool MoveThroughSpace3(Direction dir, s8 stephenRotationDir=0);
+
+  // This function checks if *whatever* is at |x, y, z| can move in a direction |dir|
+  // For example, air can always move, walls can never move, and most everything else
+  // will check the cell in front of it.
+  // This function has no direct side-effects, but does evaluate the entirety of the movement,
+  // and updates the below struct with the potential results of the call.
+  struct CPMData {
+    Vector<s8> movedSausages;
+    Vector<s8> sausagesToRoll;
+    Vector<s8> sausagesToDrop;
+    s8 sausageToSpear = -1; // This applies to *all* situations where a fork gets stuck in a sausage.
+    s8 sausageHat = -1;
+    // Bitmasks by sausage number. 64 bits, so that the overworlds (with up to 33 sausages) fit too.
+    u64 consideredSausages = 0; // We have /considered/ if this sausage can physically move and added it to movedSausages if applicable
+    u64 movingSausages = 0; // The same sausages as movedSausages, as a bitmask
+    u64 sausagesToDoubleMove = 0;
+    bool pushedFork = false;
+    bool canPhysicallyMove = false;
+  } data;
+  bool Consider(s8 sausageNo); // Helper around data.consideredSausages
+  bool CanPhysicallyMove(s8 x, s8 y, s8 z, Direction dir, bool stephenIsRotating=false);
+  // Internal function which actually does the heavy lifting.
+  bool CanPhysicallyMoveInternal(s8 x, s8 y, s8 z, Direction dir);
+  // Another internal helper because sausage carrying is complicated
+  bool IsSausageCarried(s8 x, s8 y, s8 z, Direction dir, bool stephenIsRotating, bool canDoubleMove);
+  void CheckForSausageCarry(s8 x, s8 y, s8 z, Direction dir, bool stephenIsRotating);
+
+  // The counterpart to CanPhysicallyMove, MoveThroughSpace actually enacts the proposed movement.
+  // Note that in some cases a move will have side effects but not result in stephen moving.
+  // As with CPM, a return value of false indicates a useless movement.
+  bool MoveThroughSpace(s8 x, s8 y, s8 z, Direction dir, s8 stephenRotationDir=0, bool checkSausageCarry=false, bool doSausageRotation=false, bool doDoubleMove=true);
+  bool MoveThroughSpaceInternal(s8 x, s8 y, s8 z, Direction dir, s8 stephenRotationDir=0, bool doSausageRotation=false, bool doDoubleMove=true);
+  // The two halves of MoveThroughSpaceInternal, which runs the double-moves in between them. BeginMoveThroughSpace moves
+  // everything in data.movedSausages (or spears a sausage, in which case it sets |done| and there's nothing left to do).
+  // EndMoveThroughSpace drops and cooks the sausages, moves the fork, and rotates any sausage hat.
+  bool BeginMoveThroughSpace(s8 x, s8 y, s8 z, Direction dir, bool& done);
+  bool EndMoveThroughSpace(s8 z, Direction dir, s8 stephenRotationDir, bool doSausageRotation);
+
+  // This function handles movement of stephen (and his fork) common to all the above functions.
+  // A return value of false indicates a useless move.
+  bool MoveStephenThroughSpace(Direction dir, bool ladderMotion=false);
+
+  // Saves which sausage the fork is currently stuck in (-1 if not stuck).
+  // *technically* this should live on Stephen, but it would make that > sizeof(u64).
+  s8 _sausageSpeared = -1;
+  bool _interactive = false; // Set to true while in the InteractiveSolver, allows us to emit nice errors
+
+  // Every write to a whole sausage goes through here, so that _sausageHash, _cookedSausages, and _occupancy stay in sync.
+  inline void SetSausage(s8 sausageNo, const Sausage& sausage) {
+#if ZOBRIST_HASHING
+    _sausageHash ^= SausageKey(sausageNo, _sausages[sausageNo]) ^ SausageKey(sausageNo, sausage);
+#endif
+    _cookedSausages += (s32)sausage.IsFullyCooked() - (s32)_sausages[sausageNo].IsFullyCooked();
+    const Sausage& old = _sausages[sausageNo];
+    if (sausage.x1 != old.x1 || sausage.y1 != old.y1 || sausage.x2 != old.x2 || sausage.y2 != old.y2 || sausage.z != old.z) {
+      Vacate(sausageNo, old); // Cooking and rolling don't change which cells it's in
+      Occupy(sausageNo, sausage);
+    }
+    _sausages[sausageNo] = sausage;
+  }
+
+  inline Direction Inverse(Direction dir) {
+    assert(dir > 0 && dir < 7);
+    return (Direction)(7 - dir);
+  }
+};
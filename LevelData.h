@@ -1,165 +1,258 @@
-#pragma once
-#include <initializer_list>
-#include "WitnessRNG/StdLib.h"
-
-// Mmmm, macros
-#define STAY_NEAR_THE_SAUSAGES 2
-#define HASH_CACHING 1
-#define SORT_SAUSAGE_STATE 0
-#define OVERWORLD_HACK 0
-#define SAUSAGES o(0) o(1) o(2) // o(3) // o(4)
-//  #define SAUSAGES o(0) o(1) o(2) o(3) o(4) o(5) o(6) o(7) o(8) o(9) \
-//                   o(10) o(11) o(12) o(13) o(14) o(15) o(16) o(17) // o(18) o(19) \
-//                   o(20) o(21) o(22) o(23) o(24) o(25) o(26) o(27) o(28) o(29) \
-//                   o(30) o(31) o(32)
-
-enum Direction : u8 {
-  None = 0,
-  Up = 1,
-  Left = 2,
-  Jump = 3,
-  Crouch = 4,
-  Right = 5,
-  Down = 6,
-};
-
-struct Stephen {
-  s8 x;
-  s8 y;
-  s8 z;
-  Direction dir;
-
-  s8 forkX;
-  s8 forkY;
-  s8 forkZ;
-  Direction forkDir;
-
-  Stephen() : Stephen(-1, -1, 0, None) {}
-  Stephen(s8 x_, s8 y_, s8 z_, Direction dir_) {
-    x = x_; y = y_; z = z_;
-    dir = dir_;
-    forkX = x_; forkY = y_; forkZ = z_;
-    forkDir = None;
-
-    if (dir == Up)         forkY--;
-    else if (dir == Down)  forkY++;
-    else if (dir == Left)  forkX--;
-    else if (dir == Right) forkX++;
-  }
-
-  // If the fork has no direction, then stephen is holding it (its direction matches stephen's).
-  // If it has any other value, then it is elsewhere in the world.
-  inline bool HasFork() const { return forkDir == None; }
-  bool operator==(const Stephen& other) const {
-#if _DEBUG
-    // Run some sanity checks
-    if (HasFork()) {
-      assert(forkZ == z);
-    }
-    if (other.HasFork()) {
-      assert(other.forkZ == other.z);
-    }
-#endif
-    static_assert(sizeof(Stephen) == sizeof(u64));
-    u64 a = *(u64*)this;
-    u64 b = *(u64*)&other;
-    return a == b;
-  }
-  bool operator!=(const Stephen& other) const { return !(*this == other); }
-};
-
-struct Ladder {
-  s8 x = -1;
-  s8 y = -1;
-  s8 z = -1;
-  Direction dir;
-};
-
-struct Sausage {
-  // x1, y1 will always refer to the the left- or upper- half of the sausage.
-  // This does cause some extra work while rotating, but makes comparison and referencing much easier.
-  s8 x1;
-  s8 y1;
-  s8 x2;
-  s8 y2;
-  s8 z = 0;
-
-  enum Flags : u8 {
-    None = 0,
-    Cook1A = 1, // If (x1, y1) is cooked when not rolled over
-    Cook1B = 2, // If (x1, y1) is cooked when rolled over
-    Cook2A = 4, // If (x2, y2) is cooked when not rolled over
-    Cook2B = 8, // If (x2, y2) is cooked when rolled over
-    Rolled = 16,
-    Cook1 = Cook1A | Cook1B, // If (x1, y1) is cooked on both sides
-    Cook2 = Cook2A | Cook2B, // If (x2, y2) is cooked on both sides
-    FullyCooked = Cook1A | Cook1B | Cook2A | Cook2B, // If all 4 sides are cooked
-  };
-
-  u8 flags; // Typeless because otherwise we have to define |=, &=, etc.
-  u16 _ = 0; // Unused, padding
-
-  inline bool IsVertical() const { return x1 == x2; }
-  inline bool IsHorizontal() const { return y1 == y2; }
-  inline bool IsRolled() const { return (flags & Rolled) != 0; }
-  inline bool IsAt(s8 x_, s8 y_, s8 z_) const {
-    if (z_ != z) return false;
-    if (x_ == x1 && y_ == y1) return true;
-    if (x_ == x2 && y_ == y2) return true;
-    return false;
-  }
-  inline bool IsFullyCooked() const { return (flags & FullyCooked) == FullyCooked; }
-  bool operator==(const Sausage& other) const {
-    static_assert(sizeof(Sausage) == 8);
-    u64 a = *(u64*)this;
-    u64 b = *(u64*)&other;
-    return a == b; // Assuming the padding bytes are always 0
-  }
-  bool operator!=(const Sausage& other) const { return !(*this == other); }
-};
-
-// Note the bit-masking here -- this allows us to natively represent overhangs
-enum Tile : u8 {
-  Empty  = 0,
-  Ground = 0b00000001,
-  Wall1  = 0b00000011,
-  Wall2  = 0b00000111,
-  Over2  = 0b00000101,
-  Wall3  = 0b00001111,
-  Over3  = 0b00001001,
-  Wall4  = 0b00011111,
-  Wall5  = 0b00111111,
-  Grill  = 0b01000000,
-  Unused = 0b10000000,
-};
-
-class LevelData {
-public:
-  LevelData(u8 width, u8 height, const char* name, const char* asciiGrid,
-    const Stephen& stephen = {},
-    std::initializer_list<Ladder> ladders = {},
-    std::initializer_list<Sausage> sausages = {},
-    std::initializer_list<Tile> tiles = {});
-  void Print() const;
-  bool Won() const;
-
-  s8 GetSausage(s8 x, s8 y, s8 z) const;
-  bool IsWithinGrid(s8 x, s8 y, s8 z) const;
-  bool IsWall(s8 x, s8 y, s8 z) const;
-  bool CanWalkOnto(s8 x, s8 y, s8 z) const;
-  bool IsGrill(s8 x, s8 y, s8 z) const;
-  bool IsLadder(s8 x, s8 y, s8 z, Direction dir) const;
-
-  const char* name;
-
-protected:
-  Stephen _stephen;
-  Vector<Sausage> _sausages;
-
-private:
-  u8 _width;
-  u8 _height;
-  NArray<Tile> _grid;
-  Vector<Ladder> _ladders;
-  Stephen _start;
+#pragma once
+#include <initializer_list>
+#include "WitnessRNG/StdLib.h"
+
+// Mmmm, macros
+#define HASH_CACHING 1
+#define SORT_SAUSAGE_STATE 0
+#define OVERWORLD_HACK 0
+#define ACTIVE_SAUSAGES 4 // With OVERWORLD_HACK, the most sausages which can be away from their starting position at once
+#define MACRO_MOVES 0 // Use MacroSolver, which only stores states where stephen moved something, instead of Solver.
+#define HASH_COMPACTION 0 // Use CompactSolver, which only stores a fingerprint of each state, instead of Solver.
+#define FINGERPRINT_BITS 64 // For HASH_COMPACTION. Fewer bits means more collisions, which is mostly useful for testing.
+#define DECOMPOSITION 0 // Use DecomposedSolver, which solves groups of sausages that never touch one at a time, instead of Solver.
+#define PARENT_POINTERS 0 // Store a parent ID per state instead of child edges. Slower, but fits a much larger graph in memory.
+#define FLAT_HASH_SET 1 // Store visited states in a StateSet (a flat hash table) instead of a NodeHashSet.
+#define BENCHMARK_STATE_SETS 0 // After the BFS, compare NodeHashSet and StateSet on the explored states.
+#define CUSTOM_GOAL 0 // Also find the distance to IsCustomGoal (in Solver.cpp), and solve for that instead of winning, if we can.
+#define TIMING_THREADS 0 // Threads for the timing search (DFSWinStates). 0 to use every core, 1 to search serially.
+#define ZOBRIST_HASHING 1 // Hash states with Zobrist keys, which Level keeps up to date as sausages move, instead of rehashing every sausage.
+#define SAUSAGES o(0) o(1) o(2) // o(3) // o(4)
+//  #define SAUSAGES o(0) o(1) o(2) o(3) o(4) o(5) o(6) o(7) o(8) o(9) \
+//                   o(10) o(11) o(12) o(13) o(14) o(15) o(16) o(17) // o(18) o(19) \
+//                   o(20) o(21) o(22) o(23) o(24) o(25) o(26) o(27) o(28) o(29) \
+//                   o(30) o(31) o(32)
+
+enum Direction : u8 {
+  None = 0,
+  Up = 1,
+  Left = 2,
+  Jump = 3,
+  Crouch = 4,
+  Right = 5,
+  Down = 6,
+};
+
+// How each direction is written in a .dem file. Jump and Crouch are never moves that the player makes, so they have no name.
+constexpr const char* DEM_DIRS[] = {
+  nullptr,
+  "North",
+  "West",
+  nullptr,
+  nullptr,
+  "East",
+  "South",
+};
+
+struct Stephen {
+  s8 x;
+  s8 y;
+  s8 z;
+  Direction dir;
+
+  s8 forkX;
+  s8 forkY;
+  s8 forkZ;
+  Direction forkDir;
+
+  Stephen() : Stephen(-1, -1, 0, None) {}
+  Stephen(s8 x_, s8 y_, s8 z_, Direction dir_) {
+    x = x_; y = y_; z = z_;
+    dir = dir_;
+    forkX = x_; forkY = y_; forkZ = z_;
+    forkDir = None;
+
+    if (dir == Up)         forkY--;
+    else if (dir == Down)  forkY++;
+    else if (dir == Left)  forkX--;
+    else if (dir == Right) forkX++;
+  }
+
+  // If the fork has no direction, then stephen is holding it (its direction matches stephen's).
+  // If it has any other value, then it is elsewhere in the world.
+  inline bool HasFork() const { return forkDir == None; }
+  bool operator==(const Stephen& other) const {
+#if _DEBUG
+    // Run some sanity checks
+    if (HasFork()) {
+      assert(forkZ == z);
+    }
+    if (other.HasFork()) {
+      assert(other.forkZ == other.z);
+    }
+#endif
+    static_assert(sizeof(Stephen) == sizeof(u64));
+    u64 a = *(u64*)this;
+    u64 b = *(u64*)&other;
+    return a == b;
+  }
+  bool operator!=(const Stephen& other) const { return !(*this == other); }
+};
+
+struct Ladder {
+  s8 x = -1;
+  s8 y = -1;
+  s8 z = -1;
+  Direction dir;
+};
+
+struct Sausage {
+  // x1, y1 will always refer to the the left- or upper- half of the sausage.
+  // This does cause some extra work while rotating, but makes comparison and referencing much easier.
+  s8 x1;
+  s8 y1;
+  s8 x2;
+  s8 y2;
+  s8 z = 0;
+
+  enum Flags : u8 {
+    None = 0,
+    Cook1A = 1, // If (x1, y1) is cooked when not rolled over
+    Cook1B = 2, // If (x1, y1) is cooked when rolled over
+    Cook2A = 4, // If (x2, y2) is cooked when not rolled over
+    Cook2B = 8, // If (x2, y2) is cooked when rolled over
+    Rolled = 16,
+    Cook1 = Cook1A | Cook1B, // If (x1, y1) is cooked on both sides
+    Cook2 = Cook2A | Cook2B, // If (x2, y2) is cooked on both sides
+    FullyCooked = Cook1A | Cook1B | Cook2A | Cook2B, // If all 4 sides are cooked
+  };
+
+  u8 flags; // Typeless because otherwise we have to define |=, &=, etc.
+  u16 _ = 0; // Unused, padding
+
+  inline bool IsVertical() const { return x1 == x2; }
+  inline bool IsHorizontal() const { return y1 == y2; }
+  inline bool IsRolled() const { return (flags & Rolled) != 0; }
+  inline bool IsAt(s8 x_, s8 y_, s8 z_) const {
+    if (z_ != z) return false;
+    if (x_ == x1 && y_ == y1) return true;
+    if (x_ == x2 && y_ == y2) return true;
+    return false;
+  }
+  inline bool IsFullyCooked() const { return (flags & FullyCooked) == FullyCooked; }
+  bool operator==(const Sausage& other) const {
+    static_assert(sizeof(Sausage) == 8);
+    u64 a = *(u64*)this;
+    u64 b = *(u64*)&other;
+    return a == b; // Assuming the padding bytes are always 0
+  }
+  bool operator!=(const Sausage& other) const { return !(*this == other); }
+};
+
+#if ZOBRIST_HASHING
+// A random key for every value of every field in Stephen and Sausage. A state's hash is the XOR of the keys of everything in it,
+// so when one sausage moves we can swap its old keys out and its new keys in, without touching the rest of the state.
+struct ZobristKeys {
+  u64 stephen[8][256];
+  u64 sausage[6][256];
+};
+extern const ZobristKeys ZOBRIST;
+
+inline u64 StephenKey(const Stephen& stephen) {
+  return ZOBRIST.stephen[0][(u8)stephen.x] ^ ZOBRIST.stephen[1][(u8)stephen.y] ^ ZOBRIST.stephen[2][(u8)stephen.z]
+       ^ ZOBRIST.stephen[3][stephen.dir] ^ ZOBRIST.stephen[4][(u8)stephen.forkX] ^ ZOBRIST.stephen[5][(u8)stephen.forkY]
+       ^ ZOBRIST.stephen[6][(u8)stephen.forkZ] ^ ZOBRIST.stephen[7][stephen.forkDir];
+}
+
+// The sausage tables are shared between sausages, so each sausage's key is rotated by its index.
+// Otherwise, swapping two sausages would give the same hash.
+inline u64 SausageKey(s32 i, const Sausage& sausage) {
+  u64 key = ZOBRIST.sausage[0][(u8)sausage.x1] ^ ZOBRIST.sausage[1][(u8)sausage.y1] ^ ZOBRIST.sausage[2][(u8)sausage.x2]
+          ^ ZOBRIST.sausage[3][(u8)sausage.y2] ^ ZOBRIST.sausage[4][(u8)sausage.z] ^ ZOBRIST.sausage[5][sausage.flags];
+  u32 rotation = (i * 13) & 63; // 13 is odd, so this is different for each of the first 64 sausages
+  return rotation == 0 ? key : (key << rotation) | (key >> (64 - rotation));
+}
+#endif
+
+// Note the bit-masking here -- this allows us to natively represent overhangs
+enum Tile : u8 {
+  Empty  = 0,
+  Ground = 0b00000001,
+  Wall1  = 0b00000011,
+  Wall2  = 0b00000111,
+  Over2  = 0b00000101,
+  Wall3  = 0b00001111,
+  Over3  = 0b00001001,
+  Wall4  = 0b00011111,
+  Wall5  = 0b00111111,
+  Grill  = 0b01000000,
+  Unused = 0b10000000,
+};
+
+class LevelData {
+public:
+  LevelData(u8 width, u8 height, const char* name, const char* asciiGrid,
+    const Stephen& stephen = {},
+    std::initializer_list<Ladder> ladders = {},
+    std::initializer_list<Sausage> sausages = {},
+    std::initializer_list<Tile> tiles = {});
+  void Print() const;
+  bool Won() const;
+
+  inline s8 GetSausage(s8 x, s8 y, s8 z) const {
+    s32 index = OccupancyIndex(x, y, z);
+    if (index == -1) return FindSausage(x, y, z);
+#if _DEBUG
+    assert(_occupancy[index] == FindSausage(x, y, z));
+#endif
+    return _occupancy[index];
+  }
+  bool IsWithinGrid(s8 x, s8 y, s8 z) const;
+  bool IsWall(s8 x, s8 y, s8 z) const;
+  bool CanWalkOnto(s8 x, s8 y, s8 z) const;
+  bool IsGrill(s8 x, s8 y, s8 z) const;
+  bool IsLadder(s8 x, s8 y, s8 z, Direction dir) const;
+  bool HasGround(s8 x, s8 y) const; // False for water (or other pits), where only a sausage can hold stephen up.
+
+  inline u8 Width() const { return _width; }
+  inline u8 Height() const { return _height; }
+  inline s32 SausageCount() const { return _sausages.Size(); }
+  // The current state, for reading it without a GetState.
+  inline const Stephen& CurrentStephen() const { return _stephen; }
+  inline const Sausage& CurrentSausage(s8 i) const { return _sausages[i]; }
+  // Covers everything which was passed to the constructor (except the name), i.e. the level's initial layout.
+  u64 DefinitionHash() const;
+
+  const char* name;
+
+protected:
+  Stephen _stephen;
+  Vector<Sausage> _sausages;
+  Vector<Sausage> _initialSausages;
+  s32 _cookedSausages = 0; // How many of _sausages are fully cooked, so that Won doesn't have to check each one
+  // Which sausage (or -1) is in each cell, so that GetSausage doesn't have to check every sausage. This only covers the grid,
+  // below OCCUPANCY_DEPTH. Anything outside of that (e.g. a sausage pushed off the edge) is found by FindSausage instead.
+  static constexpr s8 OCCUPANCY_DEPTH = 8;
+  Vector<s8> _occupancy;
+  inline s32 OccupancyIndex(s8 x, s8 y, s8 z) const {
+    if ((u8)x >= _width || (u8)y >= _height || (u8)z >= OCCUPANCY_DEPTH) return -1; // Also catches negative coordinates
+    return ((s32)y * _width + x) * OCCUPANCY_DEPTH + z; // z is innermost, since we usually look at a cell and the one below it
+  }
+  inline void Occupy(s8 sausageNo, const Sausage& sausage) {
+    s32 index1 = OccupancyIndex(sausage.x1, sausage.y1, sausage.z);
+    s32 index2 = OccupancyIndex(sausage.x2, sausage.y2, sausage.z);
+    if (index1 != -1) _occupancy[index1] = sausageNo;
+    if (index2 != -1) _occupancy[index2] = sausageNo;
+  }
+  // Only clears cells which are still ours, since another sausage may have already moved in (we update them one at a time).
+  inline void Vacate(s8 sausageNo, const Sausage& sausage) {
+    s32 index1 = OccupancyIndex(sausage.x1, sausage.y1, sausage.z);
+    s32 index2 = OccupancyIndex(sausage.x2, sausage.y2, sausage.z);
+    if (index1 != -1 && _occupancy[index1] == sausageNo) _occupancy[index1] = -1;
+    if (index2 != -1 && _occupancy[index2] == sausageNo) _occupancy[index2] = -1;
+  }
+  s8 FindSausage(s8 x, s8 y, s8 z) const; // The slow way, by checking every sausage
+
+#if ZOBRIST_HASHING
+  // The XOR of SausageKey for each sausage. With OVERWORLD_HACK this starts at 0 instead, i.e. the initial layout's keys are
+  // XORed out, so that (like State::Hash) it only depends on the sausages which have moved.
+  u64 _sausageHash = 0;
+#endif
+
+private:
+  u8 _width;
+  u8 _height;
+  NArray<Tile> _grid;
+  Vector<Ladder> _ladders;
+  Stephen _start;
 };
\ No newline at end of file
@@ -0,0 +1,228 @@
+#include "MacroSolver.h"
+#include "PageAllocator.h"
+#include "Solver.h"
+
+MacroSolver::MacroSolver(Level* level, const PruningProfile& pruning) : _pruning(level, pruning) {
+  _level = level;
+}
+
+bool MacroSolver::Cost::operator<(const Cost& other) const {
+  if (moves != other.moves) return moves < other.moves;
+  if (millis != other.millis) return millis < other.millis;
+  return backwardsMovements > other.backwardsMovements;
+}
+
+MacroSolver::Cost MacroSolver::Cost::operator+(const Cost& other) const {
+  Cost cost;
+  cost.moves = moves + other.moves;
+  cost.millis = millis + other.millis;
+  cost.backwardsMovements = backwardsMovements + other.backwardsMovements;
+  return cost;
+}
+
+MacroSolver::Cost MacroSolver::Cost::Plus(const Level* level, const State* state, const State* nextState, Direction dir) const {
+  Cost cost = *this;
+  cost.moves++;
+  cost.millis += Solver::ComputeMoveMillis(level, state, nextState, dir);
+  if (Solver::IsBackwardsMovement(state->stephen.dir, dir)) cost.backwardsMovements++;
+  return cost;
+}
+
+bool AllSausagesCooked(const State& state) {
+#define o(x) if (!state.GetSausage(x).IsFullyCooked()) return false;
+  SAUSAGES;
+#undef o
+  return true;
+}
+
+Vector<Direction> MacroSolver::Solve() {
+  printf("Solving %s (using macro moves)\n", _level->name);
+  if (_memoryBudget == 0) _memoryBudget = DefaultMemoryBudget();
+
+  State initialState = _level->GetState();
+  InsertNode(initialState, Cost(), 0, initialState.stephen, None, _level->Won());
+
+  Vector<WalkStep> walk;
+  u32 expandedNodes = 0;
+  while (!_queue.empty()) {
+    QueueEntry entry = _queue.top();
+    _queue.pop();
+    Node& node = _nodes[entry.nodeId];
+    if (node.expanded) continue; // We already found a cheaper route to this node
+    node.expanded = true;
+
+    if (node.won) {
+      printf("Found a solution in %d moves after expanding %d push states (%d inserted, %lld walking poses)\n",
+        node.cost.moves, expandedNodes, _nodes.Size(), _walkPoses);
+      _pruning.PrintStats();
+      Vector<Direction> solution = ReconstructSolution(entry.nodeId);
+      u64 millis = node.cost.millis;
+
+      s64 delta = millis - (solution.Size() * 160);
+      printf("Delta duration: %.03f seconds\n", delta / 1000.0);
+      printf("Solution duration: %lld.%03lld seconds\n", millis / 1000, millis % 1000);
+
+      _level->SetState(&initialState); // Be polite and make sure we restore the original level state
+      return solution;
+    }
+
+    Walk(entry.nodeId, walk);
+    expandedNodes++;
+    if (expandedNodes % 100'000 == 0) {
+      printf("Expanded %d push states, currently at %d moves\n", expandedNodes, entry.cost.moves);
+    }
+    // Node IDs are u32s (and Vector sizes are s32s), so that's a hard limit regardless of the budget.
+    size_t used = MemoryUsed();
+    if (used > _memoryBudget || _nodes.Size() > 2'000'000'000) {
+      printf("Giving up (using %.2f GB of the %.2f GB budget, %d nodes).\n", used / 1e9, _memoryBudget / 1e9, _nodes.Size());
+      break;
+    }
+  }
+
+  printf("Automatic solver could not find a solution.\n");
+  _level->SetState(&initialState);
+  return {};
+}
+
+s32 MacroSolver::Walk(u32 nodeId, Vector<WalkStep>& walk, const Stephen* target) {
+  // Copy these out, since InsertNode may reallocate _nodes.
+  State state = _nodes[nodeId].state;
+  Cost nodeCost = _nodes[nodeId].cost;
+
+  // Since every move costs exactly one move, we can process the walk one layer at a time -- by the time we're done with
+  // a layer, we've seen every way to reach the next one, so its costs (including the millisecond tiebreakers) are final.
+  std::unordered_map<u64, s32> poses; // Pose -> index in |walk|
+  walk.Resize(0);
+  WalkStep start;
+  start.pose = state.stephen;
+  walk.Push(start);
+  poses[*(u64*)&start.pose] = 0;
+
+  s32 layerStart = 0;
+  while (layerStart < walk.Size()) {
+    s32 layerEnd = walk.Size();
+    for (s32 i = layerStart; i < layerEnd; i++) {
+      state.stephen = walk[i].pose;
+      for (Direction dir : {Up, Down, Left, Right}) {
+        _level->SetState(&state);
+        if (!_level->Move(dir)) continue;
+        State nextState = _level->GetState();
+        if (!_pruning.Allows(state, nextState, target == nullptr)) continue;
+        Cost cost = walk[i].cost.Plus(_level, &state, &nextState, dir);
+
+        if (!IsWalk(state, nextState)) {
+          if (target == nullptr) InsertNode(nextState, nodeCost + cost, nodeId, state.stephen, dir, _level->Won());
+          continue;
+        }
+
+        auto it = poses.find(*(u64*)&nextState.stephen);
+        if (it == poses.end()) {
+          WalkStep step;
+          step.pose = nextState.stephen;
+          step.cost = cost;
+          step.previous = i;
+          step.dir = dir;
+          poses[*(u64*)&step.pose] = walk.Size();
+          walk.Push(step);
+        } else if (it->second >= layerEnd && cost < walk[it->second].cost) { // Only poses in the next layer can still improve
+          walk[it->second].cost = cost;
+          walk[it->second].previous = i;
+          walk[it->second].dir = dir;
+        }
+      }
+    }
+    layerStart = layerEnd;
+  }
+  _walkPoses += walk.Size();
+
+  if (target != nullptr) {
+    auto it = poses.find(*(u64*)target);
+    assert(it != poses.end());
+    return it->second;
+  }
+
+  // Walking can only win the level once everything is cooked (and then only if stephen makes it back to the start).
+  // The first pose is the node itself, which was already checked when it was inserted.
+  if (AllSausagesCooked(state)) {
+    for (s32 i = 1; i < walk.Size(); i++) {
+      state.stephen = walk[i].pose;
+      _level->SetState(&state);
+      if (!_level->Won()) continue;
+      InsertNode(_level->GetState(), nodeCost + walk[i].cost, nodeId, walk[i].pose, None, true);
+    }
+  }
+  return -1;
+}
+
+bool MacroSolver::IsWalk(const State& state, const State& nextState) const {
+#define o(x) if (state.GetSausage(x) != nextState.GetSausage(x)) return false;
+  SAUSAGES;
+#undef o
+
+  // Picking up or putting down the fork is a meaningful change, as is pushing it around while it's disconnected.
+  if (state.stephen.HasFork() != nextState.stephen.HasFork()) return false;
+  if (!state.stephen.HasFork()) {
+    if (state.stephen.forkX != nextState.stephen.forkX) return false;
+    if (state.stephen.forkY != nextState.stephen.forkY) return false;
+    if (state.stephen.forkZ != nextState.stephen.forkZ) return false;
+    if (state.stephen.forkDir != nextState.stephen.forkDir) return false;
+  }
+  return true;
+}
+
+size_t MacroSolver::MemoryUsed() const {
+  // The map allocates a node per entry, with (roughly) a next pointer, the cached hash, and a bucket pointer.
+  size_t bytes = (size_t)_nodes.Size() * sizeof(Node);
+  bytes += _nodeIds.size() * (sizeof(State) + sizeof(u32) + 3 * sizeof(void*));
+  bytes += _queue.size() * sizeof(QueueEntry);
+  return bytes;
+}
+
+void MacroSolver::InsertNode(const State& state, const Cost& cost, u32 parent, Stephen exitPose, Direction dir, bool won) {
+  auto it = _nodeIds.find(state);
+  if (it == _nodeIds.end()) {
+    u32 nodeId = _nodes.Size();
+    _nodeIds[state] = nodeId;
+    Node node;
+    node.state = state;
+    node.cost = cost;
+    node.parent = parent;
+    node.exitPose = exitPose;
+    node.dir = dir;
+    node.won = won;
+    _nodes.Push(node);
+    _queue.push({cost, nodeId});
+    return;
+  }
+
+  Node& node = _nodes[it->second];
+  if (node.expanded) return;
+  if (!(cost < node.cost)) return;
+  node.cost = cost;
+  node.parent = parent;
+  node.exitPose = exitPose;
+  node.dir = dir;
+  _queue.push({cost, it->second});
+}
+
+Vector<Direction> MacroSolver::ReconstructSolution(u32 nodeId) {
+  Vector<u32> chain;
+  for (u32 id = nodeId; id != 0; id = _nodes[id].parent) chain.Push(id);
+
+  Vector<Direction> solution;
+  Vector<WalkStep> walk;
+  Vector<Direction> segment;
+  for (s32 i = chain.Size() - 1; i >= 0; i--) {
+    const Node& node = _nodes[chain[i]];
+
+    // Re-run the parent's walk to find out how we reached the exit pose.
+    s32 step = Walk(node.parent, walk, &node.exitPose);
+    segment.Resize(0);
+    for (; walk[step].previous != -1; step = walk[step].previous) segment.Push(walk[step].dir);
+    for (s32 j = segment.Size() - 1; j >= 0; j--) solution.Push(segment[j]);
+
+    if (node.dir != None) solution.Push(node.dir);
+  }
+
+  return solution;
+}
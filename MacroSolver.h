@@ -0,0 +1,76 @@
+#pragma once
+#include "Level.h"
+#include "Pruning.h"
+#include "WitnessRNG/StdLib.h"
+#include <queue>
+#include <unordered_map>
+
+// An alternative to Solver which only stores states where a sausage (or the fork) just moved.
+// Most of the moves in a solution are stephen walking around without touching anything, and in the regular BFS every one
+// of those poses becomes its own State. Here, we instead flood-fill stephen's walkable region whenever we expand a state,
+// and only keep the moves which push something. The walk is kept as an edge weight (in moves and milliseconds),
+// which lets us run a Dijkstra over the much smaller graph and still expand the result to the exact list of inputs.
+struct MacroSolver {
+  MacroSolver(Level* level, const PruningProfile& pruning = {});
+
+  Vector<Direction> Solve();
+  // The most memory the search may use, in bytes, like Solver::SetMemoryBudget. 0 (the default) means 3/4 of the machine's RAM.
+  inline void SetMemoryBudget(size_t bytes) { _memoryBudget = bytes; }
+
+private:
+  // Compared lexicographically: fewest moves, then fewest milliseconds, then *most* backwards movements
+  // (which matches the tiebreakers in Solver::DFSWinStates).
+  struct Cost {
+    u32 moves = 0;
+    u64 millis = 0;
+    u16 backwardsMovements = 0;
+
+    bool operator<(const Cost& other) const;
+    Cost operator+(const Cost& other) const;
+    // The cost of this, followed by a single move.
+    Cost Plus(const Level* level, const State* state, const State* nextState, Direction dir) const;
+  };
+
+  // One pose reached by walking (i.e. without disturbing the sausages or a disconnected fork).
+  struct WalkStep {
+    Stephen pose;
+    Cost cost; // Relative to the start of the walk
+    s32 previous = -1; // Index into the walk, or -1 for the starting pose
+    Direction dir = None; // The move which took us from |previous| to here
+  };
+
+  // A state where something other than stephen just moved, i.e. the start of a walk.
+  struct Node {
+    State state;
+    Cost cost;
+    u32 parent = 0;
+    Stephen exitPose; // The pose in the parent's walk from which we took |dir|
+    Direction dir = None; // None if the parent's walk simply ended here (i.e. we walked into a winning pose)
+    bool won = false;
+    bool expanded = false;
+  };
+
+  struct QueueEntry {
+    Cost cost;
+    u32 nodeId;
+    bool operator<(const QueueEntry& other) const { return other.cost < cost; } // Reversed, so that the queue pops the cheapest entry
+  };
+
+  // Flood-fills stephen's poses from the node's state, one move at a time, and writes them to |walk|.
+  // Every move which disturbs something other than stephen is added to the graph through InsertNode, as is any winning pose.
+  // If |target| is provided, we're just reconstructing a solution -- nothing is inserted, and we return the target's index in |walk|.
+  s32 Walk(u32 nodeId, Vector<WalkStep>& walk, const Stephen* target = nullptr);
+  bool IsWalk(const State& state, const State& nextState) const;
+  void InsertNode(const State& state, const Cost& cost, u32 parent, Stephen exitPose, Direction dir, bool won);
+  Vector<Direction> ReconstructSolution(u32 nodeId);
+  // Roughly how many bytes the search takes up: the nodes, the map from states to nodes, and the queue.
+  size_t MemoryUsed() const;
+
+  Level* _level = nullptr;
+  Pruning _pruning;
+  Vector<Node> _nodes;
+  std::unordered_map<State, u32> _nodeIds;
+  std::priority_queue<QueueEntry> _queue;
+  u64 _walkPoses = 0;
+  size_t _memoryBudget = 0;
+};
@@ -0,0 +1,204 @@
+#include "PageAllocator.h"
+#include <cstdlib>
+#if _WIN32
+#include <Windows.h>
+#include <Psapi.h>
+#else
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cstdio>
+#endif
+
+MemoryPolicy s_policy;
+
+// Allocations still succeed when the policy can't be honored, so just make sure the user knows about it.
+// Each kind of problem is reported once, and separately, so that e.g. a huge page fallback doesn't hide a NUMA failure.
+enum class Warning : u8 {
+  Huge1GBPages,
+  HugePages,
+  TransparentHugePages,
+  Numa,
+  Count,
+};
+bool s_warned[(u8)Warning::Count] = {};
+
+void WarnOnce(Warning kind, const char* message) {
+  if (s_warned[(u8)kind]) return;
+  s_warned[(u8)kind] = true;
+  printf("Warning: %s\n", message);
+}
+
+// Nothing which allocates through here can carry on without the memory, so stop with a clear message instead of crashing later.
+void OutOfMemory(size_t bytes) {
+  printf("Error: out of memory (could not allocate %.2f GB)\n", bytes / 1e9);
+  exit(1);
+}
+
+void SetMemoryPolicy(const MemoryPolicy& policy) {
+  s_policy = policy;
+  for (bool& warned : s_warned) warned = false;
+#if _WIN32
+  if (policy.pageSize == PageSize::Huge2MB || policy.pageSize == PageSize::Huge1GB) {
+    // Large pages need SeLockMemoryPrivilege, which the account has to be granted (via secpol) -- but it also needs enabling.
+    HANDLE token;
+    if (OpenProcessToken(GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &token)) {
+      TOKEN_PRIVILEGES privileges;
+      privileges.PrivilegeCount = 1;
+      privileges.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+      if (LookupPrivilegeValueA(nullptr, "SeLockMemoryPrivilege", &privileges.Privileges[0].Luid)) {
+        AdjustTokenPrivileges(token, FALSE, &privileges, 0, nullptr, nullptr);
+      }
+      CloseHandle(token);
+    }
+  }
+#endif
+}
+
+size_t PageBytes() {
+  switch (s_policy.pageSize) {
+    case PageSize::Huge1GB:
+#if !_WIN32
+      return 1ull << 30;
+#endif
+      // Windows only has one large page size, so fall through
+    case PageSize::Huge2MB:
+#if _WIN32
+      if (GetLargePageMinimum() != 0) return GetLargePageMinimum();
+#endif
+      return 2ull << 20;
+    default:
+      return 4096;
+  }
+}
+
+size_t PhysicalMemoryBytes() {
+#if _WIN32
+  MEMORYSTATUSEX status;
+  status.dwLength = sizeof(status);
+  if (!GlobalMemoryStatusEx(&status)) return 0;
+  return (size_t)status.ullTotalPhys;
+#else
+  long pages = sysconf(_SC_PHYS_PAGES);
+  long pageSize = sysconf(_SC_PAGESIZE);
+  if (pages <= 0 || pageSize <= 0) return 0;
+  return (size_t)pages * (size_t)pageSize;
+#endif
+}
+
+size_t DefaultMemoryBudget() {
+  size_t physical = PhysicalMemoryBytes();
+  return physical == 0 ? (size_t)-1 : physical / 4 * 3;
+}
+
+size_t ResidentBytes() {
+#if _WIN32
+  PROCESS_MEMORY_COUNTERS counters;
+  if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+  return (size_t)counters.WorkingSetSize;
+#else
+  // The second field is the resident set, in pages
+  FILE* file = fopen("/proc/self/statm", "r");
+  if (file == nullptr) return 0;
+  unsigned long long total = 0, resident = 0;
+  int read = fscanf(file, "%llu %llu", &total, &resident);
+  fclose(file);
+  if (read != 2) return 0;
+  return (size_t)resident * (size_t)sysconf(_SC_PAGESIZE);
+#endif
+}
+
+#if _WIN32
+void* AllocatePages(size_t bytes) {
+  size_t pageBytes = PageBytes();
+  bytes = (bytes + pageBytes - 1) / pageBytes * pageBytes;
+
+  DWORD type = MEM_RESERVE | MEM_COMMIT;
+  if (s_policy.pageSize == PageSize::Huge2MB || s_policy.pageSize == PageSize::Huge1GB) type |= MEM_LARGE_PAGES;
+  if (s_policy.numa == NumaPolicy::Interleave) {
+    WarnOnce(Warning::Numa, "NUMA interleaving is not supported on Windows, so pages will go to whichever node touches them first");
+  }
+
+  auto allocate = [&](DWORD type) {
+    if (s_policy.numa == NumaPolicy::Bind) {
+      return VirtualAllocExNuma(GetCurrentProcess(), nullptr, bytes, type, PAGE_READWRITE, s_policy.numaNode);
+    }
+    return VirtualAlloc(nullptr, bytes, type, PAGE_READWRITE);
+  };
+  void* memory = allocate(type);
+  if (memory == nullptr && (type & MEM_LARGE_PAGES)) {
+    WarnOnce(Warning::HugePages, "could not allocate large pages (does this account have the 'Lock pages in memory' right?), "
+      "falling back to regular pages");
+    memory = allocate(MEM_RESERVE | MEM_COMMIT);
+  }
+  if (memory == nullptr) OutOfMemory(bytes);
+  return memory; // VirtualAlloc memory is already zeroed
+}
+
+void FreePages(void* memory, size_t bytes) {
+  VirtualFree(memory, 0, MEM_RELEASE);
+}
+#else
+// From linux/mempolicy.h, which isn't always installed (and libnuma usually isn't).
+#define MPOL_BIND 2
+#define MPOL_INTERLEAVE 3
+
+void ApplyNumaPolicy(void* memory, size_t bytes) {
+  if (s_policy.numa == NumaPolicy::Default) return;
+
+  u64 nodeMask = 0;
+  if (s_policy.numa == NumaPolicy::Bind) {
+    assert(s_policy.numaNode < 64); // Main rejects anything larger
+    nodeMask = 1ull << s_policy.numaNode;
+  } else {
+    char path[64];
+    for (u32 node=0; node<64; node++) {
+      snprintf(path, sizeof(path), "/sys/devices/system/node/node%d", node);
+      if (access(path, F_OK) == 0) nodeMask |= 1ull << node;
+    }
+  }
+
+  // This has to happen before anything touches the memory, since that's when the pages are actually placed.
+  int mode = (s_policy.numa == NumaPolicy::Bind ? MPOL_BIND : MPOL_INTERLEAVE);
+  if (nodeMask == 0 || syscall(SYS_mbind, memory, bytes, mode, &nodeMask, 64, 0) != 0) {
+    WarnOnce(Warning::Numa, "could not apply the NUMA policy, so pages will go to whichever node touches them first");
+  }
+}
+
+void* AllocatePages(size_t bytes) {
+  size_t pageBytes = PageBytes();
+  bytes = (bytes + pageBytes - 1) / pageBytes * pageBytes;
+
+  // Each page size falls back to the next smaller one. |bytes| stays rounded up to the policy's page size, which is a multiple
+  // of all of them, so FreePages works out the same length whichever one we got.
+  const int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+  void* memory = MAP_FAILED;
+  if (s_policy.pageSize == PageSize::Huge1GB) {
+    memory = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, flags | MAP_HUGETLB | (30 << MAP_HUGE_SHIFT), -1, 0);
+    if (memory == MAP_FAILED) {
+      WarnOnce(Warning::Huge1GBPages, "could not allocate 1GB pages (are any reserved in "
+        "/sys/kernel/mm/hugepages/hugepages-1048576kB/nr_hugepages?), trying 2MB pages");
+    }
+  }
+  if (memory == MAP_FAILED && (s_policy.pageSize == PageSize::Huge2MB || s_policy.pageSize == PageSize::Huge1GB)) {
+    memory = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, flags | MAP_HUGETLB | (21 << MAP_HUGE_SHIFT), -1, 0);
+    if (memory == MAP_FAILED) {
+      WarnOnce(Warning::HugePages, "could not allocate 2MB pages (are any reserved in /proc/sys/vm/nr_hugepages?), "
+        "falling back to regular pages");
+    }
+  }
+  if (memory == MAP_FAILED) memory = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, flags, -1, 0);
+  if (memory == MAP_FAILED) OutOfMemory(bytes);
+
+  if (s_policy.pageSize == PageSize::Transparent && madvise(memory, bytes, MADV_HUGEPAGE) != 0) {
+    WarnOnce(Warning::TransparentHugePages, "transparent huge pages are not available, so this uses regular pages");
+  }
+  ApplyNumaPolicy(memory, bytes);
+  return memory; // Anonymous mappings are already zeroed
+}
+
+void FreePages(void* memory, size_t bytes) {
+  size_t pageBytes = PageBytes();
+  munmap(memory, (bytes + pageBytes - 1) / pageBytes * pageBytes);
+}
+#endif
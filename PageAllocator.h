@@ -0,0 +1,40 @@
+#pragma once
+#include "WitnessRNG/StdLib.h"
+
+// On large levels, the visited set and its state arena are tens of GB, and the hash lookups into them are random -- so with
+// regular 4k pages, almost every lookup also misses the TLB. Those allocations go through here instead, which can ask the
+// OS for huge pages and control which NUMA node(s) the memory lands on.
+// If the OS refuses, we warn (once for each kind of problem) and fall back: 1GB pages to 2MB pages to regular pages, and any
+// NUMA policy to the default. So any policy is safe to pick on any machine.
+enum class PageSize : u8 {
+  Default,     // Regular pages
+  Transparent, // Regular pages, but ask Linux to back them with transparent huge pages (madvise). Same as Default on Windows.
+  Huge2MB,     // Explicit huge pages (MAP_HUGETLB on Linux, MEM_LARGE_PAGES on Windows, which picks the size itself)
+  Huge1GB,     // Explicit 1GB pages. On Windows this is the same as Huge2MB.
+};
+
+enum class NumaPolicy : u8 {
+  Default,    // Pages land on whichever node first touches them
+  Interleave, // Spread pages round-robin across all nodes (Linux only)
+  Bind,       // Only use MemoryPolicy::numaNode
+};
+
+struct MemoryPolicy {
+  PageSize pageSize = PageSize::Default;
+  NumaPolicy numa = NumaPolicy::Default;
+  u8 numaNode = 0;
+};
+
+// Applies to every allocation made after this call.
+void SetMemoryPolicy(const MemoryPolicy& policy);
+// The allocation granularity for the current policy. Allocations are rounded up to this, so size blocks to fit.
+size_t PageBytes();
+// The machine's total RAM, or 0 if we can't tell.
+size_t PhysicalMemoryBytes();
+// What the solvers may use when --memory isn't given: 3/4 of the machine's RAM, or no limit at all if we can't tell.
+size_t DefaultMemoryBudget();
+// How much of this process is actually in RAM right now, or 0 if we can't tell. Used to measure allocations we don't control.
+size_t ResidentBytes();
+// Returns zeroed memory. |bytes| must be passed back to FreePages. If the OS has no memory left, prints an error and exits.
+void* AllocatePages(size_t bytes);
+void FreePages(void* memory, size_t bytes);
@@ -0,0 +1,203 @@
+#include "PatternDatabase.h"
+#include "GraphFile.h"
+#include <cstdio>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+// The file is just this header, followed by the tables.
+struct PatternFileHeader {
+  char magic[4];
+  u32 engineVersion;
+  u64 key; // Identifies the level and its starting state
+  u32 sausageCount;
+  u32 tableSize;
+};
+
+// Stephen (with his fork) and the one sausage we're looking at.
+struct Pose {
+  Stephen stephen;
+  Sausage sausage;
+  bool operator==(const Pose& other) const { return stephen == other.stephen && sausage == other.sausage; }
+};
+
+struct PoseHash {
+  size_t operator()(const Pose& pose) const {
+    u64 a, b;
+    memcpy(&a, &pose.stephen, sizeof(a));
+    memcpy(&b, &pose.sausage, sizeof(b));
+    return (size_t)((a ^ (b * 0x9e3779b97f4a7c15ull)) * 0xff51afd7ed558ccdull >> 17);
+  }
+};
+
+PatternDatabase::PatternDatabase(Level* level, const char* path, std::chrono::steady_clock::time_point deadline) {
+  _deadline = deadline;
+  _width = level->Width();
+  _height = level->Height();
+  _sausageCount = level->SausageCount();
+  _tableSize = Z_LEVELS * _height * _width * 2 * 32;
+
+  u64 key = Key(level);
+  if (path != nullptr && Load(path, key)) {
+    printf("Loaded pattern databases from %s\n", path);
+    return;
+  }
+
+  Build(level);
+  if (path != nullptr && _complete) Save(path, key);
+}
+
+void PatternDatabase::Build(Level* level) {
+  _tables.Resize(_sausageCount * _tableSize);
+  for (s32 i=0; i<_tables.Size(); i++) _tables[i] = NO_BOUND;
+
+  State start = level->GetState();
+  for (s32 i=0; i<_sausageCount; i++) BuildSausage(level, i, start);
+  level->SetState(&start); // Be polite and make sure we restore the original level state
+}
+
+void PatternDatabase::BuildSausage(Level* level, s32 i, const State& start) {
+  // Every other sausage is moved out of the world, the same way the overworld retires them.
+  std::vector<Sausage> layout(_sausageCount);
+  for (s32 j=0; j<_sausageCount; j++) {
+    layout[j] = start.GetSausage(j);
+    if (j == i) continue;
+    layout[j].x1 = layout[j].y1 = layout[j].x2 = layout[j].y2 = -127;
+    layout[j].z = -2;
+    layout[j].flags = Sausage::Flags::FullyCooked;
+  }
+
+  // First, explore everything forwards (since that's the only direction Level::Move goes).
+  std::vector<Pose> poses;
+  std::vector<u32> successors; // 4 per pose, NO_NODE if the move was illegal
+  std::unordered_map<Pose, u32, PoseHash> ids;
+  poses.push_back({start.stephen, start.GetSausage(i)});
+  ids[poses[0]] = 0;
+  for (u32 id=0; id<poses.size(); id++) {
+    if (poses.size() > 50'000'000) {
+      printf("Giving up on the pattern database for sausage %d (too many poses).\n", i);
+      return;
+    }
+    if ((id & 0xFFF) == 0 && std::chrono::steady_clock::now() >= _deadline) {
+      printf("Giving up on the pattern database for sausage %d (out of time).\n", i);
+      _complete = false;
+      return;
+    }
+    successors.resize(successors.size() + 4, NO_NODE);
+    Pose pose = poses[id];
+    if (pose.sausage.IsFullyCooked()) continue; // Done, no need to go any further
+
+    layout[i] = pose.sausage;
+    u32 edge = 0;
+    for (Direction dir : {Up, Down, Left, Right}) {
+      level->SetState(pose.stephen, &layout[0]);
+      if (level->Move(dir)) {
+        State nextState = level->GetState();
+        Pose nextPose = {nextState.stephen, nextState.GetSausage(i)};
+        auto it = ids.find(nextPose);
+        if (it == ids.end()) {
+          it = ids.emplace(nextPose, (u32)poses.size()).first;
+          poses.push_back(nextPose);
+        }
+        successors[id * 4 + edge] = it->second;
+      }
+      edge++;
+    }
+  }
+
+  // Then walk the edges backwards from every cooked pose. Distances saturate just below NO_BOUND, which is still a lower bound.
+  std::vector<u32> predecessorStart(poses.size() + 1, 0);
+  for (u32 next : successors) {
+    if (next != NO_NODE) predecessorStart[next + 1]++;
+  }
+  for (size_t id=0; id<poses.size(); id++) predecessorStart[id + 1] += predecessorStart[id];
+  std::vector<u32> predecessors(predecessorStart.back());
+  std::vector<u32> fill(predecessorStart.begin(), predecessorStart.end() - 1);
+  for (size_t edge=0; edge<successors.size(); edge++) {
+    if (successors[edge] != NO_NODE) predecessors[fill[successors[edge]]++] = (u32)(edge / 4);
+  }
+
+  std::vector<u8> distances(poses.size(), NO_BOUND);
+  std::vector<u32> queue;
+  for (u32 id=0; id<poses.size(); id++) {
+    if (!poses[id].sausage.IsFullyCooked()) continue;
+    distances[id] = 0;
+    queue.push_back(id);
+  }
+  for (size_t head=0; head<queue.size(); head++) {
+    u32 id = queue[head];
+    u8 distance = (distances[id] >= NO_BOUND - 1 ? NO_BOUND - 1 : distances[id] + 1);
+    for (u32 j=predecessorStart[id]; j<predecessorStart[id + 1]; j++) {
+      u32 previous = predecessors[j];
+      if (distances[previous] != NO_BOUND) continue;
+      distances[previous] = distance;
+      queue.push_back(previous);
+    }
+  }
+
+  // Finally, forget about stephen and keep the best distance for each placement of the sausage.
+  u8* table = &_tables[i * _tableSize];
+  s32 placements = 0;
+  for (size_t id=0; id<poses.size(); id++) {
+    if (distances[id] == NO_BOUND) continue;
+    s32 index = Index(poses[id].sausage);
+    if (index < 0) continue;
+    if (table[index] == NO_BOUND) placements++;
+    if (distances[id] < table[index]) table[index] = distances[id];
+  }
+  printf("Pattern database for sausage %d: %zd poses, %d placements, at least %d moves to cook from the start\n",
+    i, poses.size(), placements, SausageBound(i, start.GetSausage(i)));
+}
+
+u64 PatternDatabase::Key(const Level* level) const {
+  State start = level->GetState();
+  u64 key = level->DefinitionHash();
+  key = HashBytes(key, &start.stephen, sizeof(start.stephen));
+  for (s32 i=0; i<_sausageCount; i++) {
+    Sausage sausage = start.GetSausage(i);
+    key = HashBytes(key, &sausage, sizeof(sausage));
+  }
+  key = HashBytes(key, &_tableSize, sizeof(_tableSize));
+  return key;
+}
+
+bool PatternDatabase::Load(const char* path, u64 key) {
+  MappedFile file(path);
+  if (file.Data() == nullptr) return false; // Probably just doesn't exist yet
+
+  PatternFileHeader header;
+  if (file.Size() < sizeof(header)) return false;
+  memcpy(&header, file.Data(), sizeof(header));
+  if (memcmp(header.magic, "SSRP", 4) != 0) return false;
+  if (header.engineVersion != ENGINE_VERSION) {
+    printf("Pattern databases in %s are from an older engine, rebuilding\n", path);
+    return false;
+  }
+  if (header.key != key || header.sausageCount != (u32)_sausageCount || header.tableSize != (u32)_tableSize) {
+    printf("Pattern databases in %s are for a different level, rebuilding\n", path);
+    return false;
+  }
+  if (file.Size() != sizeof(header) + (size_t)_sausageCount * _tableSize) return false;
+
+  _tables.Resize(_sausageCount * _tableSize);
+  memcpy(&_tables[0], file.Data() + sizeof(header), _tables.Size());
+  return true;
+}
+
+void PatternDatabase::Save(const char* path, u64 key) const {
+  FILE* file = fopen(path, "wb");
+  if (file == nullptr) {
+    printf("Could not open %s to save the pattern databases\n", path);
+    return;
+  }
+
+  PatternFileHeader header;
+  memcpy(header.magic, "SSRP", 4);
+  header.engineVersion = ENGINE_VERSION;
+  header.key = key;
+  header.sausageCount = _sausageCount;
+  header.tableSize = _tableSize;
+  fwrite(&header, sizeof(header), 1, file);
+  fwrite(&_tables[0], 1, _tables.Size(), file);
+  fclose(file);
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include "Level.h"
+#include "WitnessRNG/StdLib.h"
+#include <chrono>
+
+// Lower bounds on the number of moves left, for informed searches.
+// For each sausage, we take the level with every *other* sausage removed, and explore every reachable combination of
+// stephen (including the fork) and that one sausage. Then we walk backwards from the poses where the sausage is fully
+// cooked to get the distance to cooking it, and keep the smallest distance for each placement of the sausage
+// (position, orientation, and cook flags). Looking up a state is then one table read per sausage.
+//
+// Caveat: removing sausages isn't a perfect relaxation, since the other sausages can also help (e.g. as a bridge across
+// water), so on some levels the bound can be too high. Placements which we never reached in isolation have no bound.
+class PatternDatabase {
+public:
+  // Loads the tables from |path| if they were built for this level (and engine version), otherwise builds them from
+  // the level's current state and saves them there. |path| may be null, in which case we always build.
+  // Any sausage which isn't done by |deadline| gets no bounds at all (which is still a valid lower bound), and isn't saved.
+  PatternDatabase(Level* level, const char* path = nullptr,
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max());
+
+  // The largest of the per-sausage bounds. Each table already counts every move stephen makes, so the bounds overlap
+  // and can't be added together -- one move may well be making progress on several sausages at once.
+  inline u8 LowerBound(const State& state) const {
+    u8 bound = 0;
+    for (s32 i=0; i<_sausageCount; i++) {
+      u8 distance = SausageBound(i, state.GetSausage(i));
+      if (distance > bound) bound = distance;
+    }
+    return bound;
+  }
+  // Whether LowerBound can be trusted to never overestimate. With one sausage, removing the others removes nothing, and
+  // the table covers every pose the real level can reach -- so the only loss is forgetting where stephen is, which only
+  // makes the bound lower. With more, see the caveat above.
+  inline bool Admissible() const { return _sausageCount <= 1; }
+  // The number of moves to fully cook sausage |i| from |sausage|, or 0 if we don't know.
+  inline u8 SausageBound(s32 i, const Sausage& sausage) const {
+    s32 index = Index(sausage);
+    if (index < 0) return 0;
+    u8 distance = _tables[i * _tableSize + index];
+    return distance == NO_BOUND ? 0 : distance;
+  }
+
+private:
+  static constexpr u8 NO_BOUND = 0xFF;
+  static constexpr s32 Z_LEVELS = 8; // Sausages can sit on walls, but nothing in the game is taller than this
+
+  // Position, orientation, then flags -- so that every flag combination for a placement shares a cache line.
+  inline s32 Index(const Sausage& sausage) const {
+    if (sausage.z < 0 || sausage.z >= Z_LEVELS) return -1; // Including sausages which have been removed from play
+    if (sausage.x1 < 0 || sausage.x1 >= _width || sausage.y1 < 0 || sausage.y1 >= _height) return -1;
+    s32 placement = (sausage.z * _height + sausage.y1) * _width + sausage.x1;
+    return ((placement * 2 + sausage.IsVertical()) << 5) | (sausage.flags & 0x1F);
+  }
+
+  void Build(Level* level);
+  void BuildSausage(Level* level, s32 i, const State& start);
+  u64 Key(const Level* level) const;
+  bool Load(const char* path, u64 key);
+  void Save(const char* path, u64 key) const;
+
+  s32 _width = 0;
+  s32 _height = 0;
+  s32 _sausageCount = 0;
+  s32 _tableSize = 0;
+  Vector<u8> _tables; // One table per sausage, back-to-back
+  std::chrono::steady_clock::time_point _deadline;
+  bool _complete = true; // False if we ran out of time on any sausage
+};
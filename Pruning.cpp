@@ -0,0 +1,118 @@
+#include "Pruning.h"
+#include <cmath>
+#include <cstring>
+#include <cstdio>
+
+Pruning::Pruning(const LevelData* level, const PruningProfile& profile) {
+  _profile = profile;
+  _width = level->Width();
+  _height = level->Height();
+  _cells = _width * _height;
+
+  if (_profile.maxSausageDistance > 0) BuildDistanceFields(level);
+
+  if (_profile.regionMask != nullptr) {
+    assert(strlen(_profile.regionMask) == _cells);
+    _forbidden.Resize(_cells);
+    for (s32 i=0; i<_cells; i++) _forbidden[i] = (_profile.regionMask[i] == 'x');
+  }
+}
+
+void Pruning::BuildDistanceFields(const LevelData* level) {
+  _distances.Resize(_cells * _cells);
+
+  if (!_profile.walkingDistance) {
+    // Rounding up means that "distance <= limit" is the same as "distanceSquared <= limit * limit", which was the old check.
+    for (s32 a=0; a<_cells; a++) {
+      for (s32 b=0; b<_cells; b++) {
+        s32 dx = (a % _width) - (b % _width);
+        s32 dy = (a / _width) - (b / _width);
+        double distance = ceil(sqrt((double)(dx * dx + dy * dy)));
+        _distances[a * _cells + b] = (distance >= 0xFF ? 0xFF : (u8)distance);
+      }
+    }
+    return;
+  }
+
+  // A BFS from every cell. Stephen can cross water by standing on a sausage, so we let the search step *onto* a cell
+  // without ground (so that it has a distance), but not continue through it.
+  Vector<s32> queue;
+  for (s32 source=0; source<_cells; source++) {
+    u8* field = &_distances[source * _cells];
+    for (s32 i=0; i<_cells; i++) field[i] = 0xFF;
+    field[source] = 0;
+    queue.Resize(0);
+    queue.Push(source);
+    for (s32 head=0; head<queue.Size(); head++) {
+      s32 cell = queue[head];
+      s8 x = cell % _width;
+      s8 y = cell / _width;
+      if (cell != source && !level->HasGround(x, y)) continue;
+      if (field[cell] == 0xFE) continue; // Any further would overflow
+
+      const s8 dx[] = {0, 0, -1, +1};
+      const s8 dy[] = {-1, +1, 0, 0};
+      for (s32 i=0; i<4; i++) {
+        if (!level->IsWithinGrid(x + dx[i], y + dy[i], 0)) continue;
+        s32 next = (y + dy[i]) * _width + (x + dx[i]);
+        if (field[next] != 0xFF) continue;
+        field[next] = field[cell] + 1;
+        queue.Push(next);
+      }
+    }
+  }
+}
+
+bool Pruning::Allows(const State& state, const State& nextState, bool recordStats) {
+  return AllowsInternal(state, nextState.stephen, [&nextState](u8 i) { return nextState.GetSausage(i); }, recordStats);
+}
+
+bool Pruning::Allows(const State& state, const LevelData& level, bool recordStats) {
+  return AllowsInternal(state, level.CurrentStephen(), [&level](u8 i) -> const Sausage& { return level.CurrentSausage(i); }, recordStats);
+}
+
+template<typename GetSausageFn>
+bool Pruning::AllowsInternal(const State& state, const Stephen& stephen, GetSausageFn getSausage, bool recordStats) {
+  bool allCooked = true;
+#define o(x) if (!getSausage(x).IsFullyCooked()) allCooked = false;
+  SAUSAGES;
+#undef o
+  if (allCooked) return true;
+
+  if (stephen.x == state.stephen.x && stephen.y == state.stephen.y && stephen.z == state.stephen.z) return true;
+
+  if (_forbidden.Size() > 0 && _forbidden[stephen.y * _width + stephen.x]) {
+    if (recordStats) _cutByRegion++;
+    return false;
+  }
+
+  if (_profile.maxSausageDistance > 0) {
+    bool closeToAnySausage = false;
+#define o(i) { \
+      Sausage sausage = getSausage(i); \
+      if (sausage.z >= 0 \
+        && (Distance(stephen.x, stephen.y, sausage.x1, sausage.y1) <= _profile.maxSausageDistance \
+         || Distance(stephen.x, stephen.y, sausage.x2, sausage.y2) <= _profile.maxSausageDistance)) { \
+        closeToAnySausage = true; \
+      } \
+    }
+    SAUSAGES;
+#undef o
+
+    if (!closeToAnySausage) {
+      if (recordStats) _cutByDistance++;
+      return false;
+    }
+  }
+
+  return true;
+}
+
+void Pruning::PrintStats() const {
+  if (_profile.maxSausageDistance > 0) {
+    printf("Pruned %lld moves which took stephen more than %d units from all sausages\n", _cutByDistance, _profile.maxSausageDistance);
+  }
+  if (_forbidden.Size() > 0) {
+    printf("Pruned %lld moves which took stephen outside of the region mask\n", _cutByRegion);
+  }
+}
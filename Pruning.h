@@ -0,0 +1,54 @@
+#pragma once
+#include "LevelData.h"
+#include "State.h"
+#include "WitnessRNG/StdLib.h"
+
+// Runtime policies for shrinking the search space. These are heuristics -- they can (and do) cut optimal routes --
+// so they live outside of Level::Move, and each one reports how much it cut. Run with a tight profile for speed,
+// and then with a looser one (or none at all) to verify the result.
+//
+// None of the policies apply once every sausage is cooked, since stephen still needs to walk back to the start.
+struct PruningProfile {
+  // Reject moves which take stephen more than this many cells away from every sausage. 0 disables the policy.
+  // Moves where stephen stays put (e.g. rotations) are never rejected, even if they push a sausage away.
+  u8 maxSausageDistance = 0;
+  // If false, distances are euclidean (which is what STAY_NEAR_THE_SAUSAGES used to do).
+  // If true, distances are step counts across the level's terrain, so a sausage on the other side of the water is far away.
+  bool walkingDistance = false;
+  // Optional, a grid the same size as the level where 'x' marks cells that stephen should never enter.
+  const char* regionMask = nullptr;
+};
+
+class Pruning {
+public:
+  Pruning(const LevelData* level, const PruningProfile& profile);
+
+  // Returns false if the move from |state| to |nextState| should not be explored.
+  // If |recordStats| is set, a rejection is tallied against the policy which made it.
+  bool Allows(const State& state, const State& nextState, bool recordStats = true);
+  // Same, but the move is to wherever |level| is right now, so that we don't need to build a State for it.
+  bool Allows(const State& state, const LevelData& level, bool recordStats = true);
+  void PrintStats() const;
+  inline const PruningProfile& Profile() const { return _profile; }
+
+private:
+  // |getSausage| returns the i-th sausage of the state we're moving to.
+  template<typename GetSausageFn>
+  bool AllowsInternal(const State& state, const Stephen& stephen, GetSausageFn getSausage, bool recordStats);
+  void BuildDistanceFields(const LevelData* level);
+  // Half of a sausage can hang off the edge of the level, which counts as unreachable.
+  inline u8 Distance(s8 x1, s8 y1, s8 x2, s8 y2) const {
+    if (x2 < 0 || x2 >= _width || y2 < 0 || y2 >= _height) return 0xFF;
+    return _distances[(y1 * _width + x1) * _cells + (y2 * _width + x2)];
+  }
+
+  PruningProfile _profile;
+  s32 _width = 0;
+  s32 _height = 0;
+  s32 _cells = 0;
+  Vector<u8> _distances; // A distance field for each cell, capped at 0xFF (unreachable)
+  Vector<u8> _forbidden; // From the region mask, empty if there is none
+
+  u64 _cutByDistance = 0;
+  u64 _cutByRegion = 0;
+};
@@ -1,316 +1,993 @@
-#include "Solver.h"
-#include "Level.h"
-#include <unordered_set>
-#include <unordered_map>
-
-Solver::Solver(Level* level) {
-  _level = level;
-}
-
-Solver::~Solver() {
-  printf("Destroying _visitedNodes\n");
-}
-
-u16 Score(State* state) {
-  u16 score = 0;
-  u16 sidesCooked;
-  u8 flags;
-#define o(x) { \
-    flags = state->sausages[x].flags; \
-    sidesCooked = (flags & Sausage::Flags::FullyCooked); \
-    if (sidesCooked == Sausage::Flags::FullyCooked) score += 100; \
-    else score += __popcnt16(sidesCooked); \
-  }
-
-  SAUSAGES;
-#undef o
-  return score;
-}
-
-Vector<Direction> Solver::Solve() {
-  printf("Solving %s\n", _level->name);
-
-  State* initialState;
-  _visitedNodes2.CopyAdd(_level->GetState(), &initialState);
-  initialState->shallow = _shallowAlloc.make<ShallowState>();
-  _unexplored.AddToTail(initialState);
-
-  BFSStateGraph();
-
-  printf("Traversal done in %zd nodes.\n", _visitedNodes2.Size());
-
-  ComputeWinningStates();
-
-  u32 winningStates = 0;
-  for (ShallowState* shallow : _explored2) {
-    if (shallow->winDistance != UNWINNABLE) winningStates++;
-  }
-
-  printf("Of the %zd nodes, %d are winning.\n", _visitedNodes2.Size(), winningStates);
-
-  _level->SetState(initialState); // Be polite and make sure we restore the original level state
-  if (initialState->shallow == nullptr || initialState->shallow->winDistance == UNWINNABLE) {
-    printf("Automatic solver could not find a solution.\n");
-    u16 bestScore = 0;
-    for (State* state : _explored) {
-      u16 score = Score(state);
-      if (score > bestScore) bestScore = score;
-    }
-    printf("Best score: %d\n", bestScore);
-    for (State* state : _explored) {
-      u16 score = Score(state);
-      if (score == bestScore) {
-        state->shallow->winDistance = 0;
-      }
-    }
-
-    ComputeWinningStates();
-  }
-
-  printf("Found the shortest # of moves: %d\n", initialState->shallow->winDistance);
-  printf("Done computing victory states\n");
-
-  DFSWinStates(initialState, 0, 0);
-
-  s64 delta = _bestMillis - (_bestSolution.Size() * 160);
-  printf("Delta duration: %.03f seconds\n", delta / 1000.0);
-  printf("Solution duration: %lld.%02lld seconds\n", _bestMillis / 1000, _bestMillis % 1000);
-
-  return _bestSolution.Copy();
-}
-
-void Solver::BFSStateGraph() {
-  State depthMarker;
-  depthMarker.shallow = new ShallowState(); // Just so that state->shallow->winDistance works.
-  u16 depth = 0;
-  _unexplored.AddToTail(&depthMarker);
-
-  while (_unexplored.Head() != nullptr) {
-    State* state = _unexplored.Head();
-    if (state->shallow->winDistance == 0) { // Delayed addition of winning nodes to keep _explored in order
-      _unexplored.AdvanceHead();
-      _explored.AddToTail(state);
-      continue;
-    }
-
-    if (state == &depthMarker) {
-      printf("Finished processing depth %d, ", depth);
-      if (_unexplored.Size() == 1) { // Only the dummy state is left in queue, queue is essentially empty
-        printf("BFS exploration complete (no nodes remaining).\n");
-        break;
-      } else if (_visitedNodes2.Size() > 150'000'000) {
-        printf("giving up (too many nodes).\n");
-        break;
-      } else if (depth == _winningDepth + 2) {
-        // I add a small fudge-factor here (2 iterations) to search for solutions
-        // which potentially take more moves, but are faster in realtime.
-        printf("not exploring any further, since the winning state was at depth %d.\n", _winningDepth);
-        break;
-      }
-
-      depth++;
-      _unexplored.AdvanceHead();
-      printf("there are %d nodes to explore at depth %d\n", _unexplored.Size(), depth);
-      _unexplored.AddToTail(&depthMarker);
-      continue;
-    }
-
-    _level->SetState(state);
-    if (_level->Move(Up))    state->u = GetOrInsertState(depth);
-    _level->SetState(state);
-    if (_level->Move(Down))  state->d = GetOrInsertState(depth);
-    _level->SetState(state);
-    if (_level->Move(Left))  state->l = GetOrInsertState(depth);
-    _level->SetState(state);
-    if (_level->Move(Right)) state->r = GetOrInsertState(depth);
-
-    _unexplored.AdvanceHead();
-    _explored.AddToTail(state);
-  }
-}
-
-State* Solver::GetOrInsertState(u16 depth) {
-  State* state;
-  bool inserted = _visitedNodes2.CopyAdd(_level->GetState(), &state);
-  if (!inserted) return state; // State was already analyzed, or allocation failed
-
-  if (_visitedNodes2.Size() % 100'000 == 0) {
-    //_level->Print();
-  }
-
-  state->shallow = _shallowAlloc.make<ShallowState>();
-
-  if (_level->Won()) {
-      state->shallow->winDistance = 0;
-      if (_winningDepth == UNWINNABLE) {
-        // Once we find a winning state, we have reached the minimum depth for a solution.
-        // Ergo, we should not explore the tree deeper than that solution. Since we're a BFS,
-        // that means we should finish the current depth, but not explore any further.
-        _winningDepth = depth + 1; // +1 because the winning move is at the *next* depth, not the current one.
-        printf("Found the first winning state at depth %d!\n", _winningDepth);
-      }
-      // Even though this state is winning, we add it to the unexplored list as usual,
-      // in order to keep the _explored list in depth-sorted order.
-  }
-
-  _unexplored.AddToTail(state);
-  return state;
-}
-
-void Solver::CreateShallowStates() {
-  _explored2 = LinkedLoop<ShallowState>(); // Clear the shallow state list in case we're re-evaluating after failing to win.
-
-  // Second iteration because we need shallow copies of the udlr states. (maybe not?)
-  printf("Populating shallow states:                                                                          |\n");
-  for (State* state : _explored) {
-    ShallowState* shallow = state->shallow;
-    if (state->u) shallow->u = state->u->shallow;
-    if (state->d) shallow->d = state->d->shallow;
-    if (state->l) shallow->l = state->l->shallow;
-    if (state->r) shallow->r = state->r->shallow;
-    _explored2.AddCurrent(shallow);
-    if (_explored2.Size() % (_explored.Size() / 100) == 0) printf("#");
-  }
-
-  printf("|\n");
-}
-
-void Solver::ComputeWinningStates() {
-  /* Even though we generate the list in order, we should not remove states from the loop, and we may need to do multiple loops.
-     For example, consider this graph: A is at depth 0, B and D are at 1, C is at 2.
-     A -> (D)
-       \v   ^\
-         B -> C
-
-    Although C->D is a sub-optimal move (depth is decreasing), C is still a winning state. Since we process in depth order,
-    we will process C, D, B, A -- ergo when we check D the first time it won't be marked winning.
-    But, we do still want to mark C as winning -- since we haven't *truly* computed the costs yet, we don't know if it's faster.
-  */
-
-  // Reducing the memory required to represent the tree by removing sausages positions from State.
-  // This helps to avoid paging with very large trees.
-  CreateShallowStates();
-
-  printf("Computing winning states to achieve the best score\n");
-
-  // If (somehow) we make it through the entire loop and find no win states, this is the correct exit condition.
-  // It is very likely that this value will be updated during iteration.
-  ShallowState* endOfLoop = _explored2.Previous();
-
-  while (true) {
-    ShallowState* shallow = _explored2.Current();
-    if (shallow == nullptr) break; // All states are winning
-
-    u16 winDistance = shallow->winDistance;
-
-    ShallowState* nextState = shallow->u;
-    if (nextState != nullptr && nextState->winDistance < winDistance) {
-      winDistance = nextState->winDistance;
-    }
-    nextState = shallow->d;
-    if (nextState != nullptr && nextState->winDistance < winDistance) {
-      winDistance = nextState->winDistance;
-    }
-    nextState = shallow->l;
-    if (nextState != nullptr && nextState->winDistance < winDistance) {
-      winDistance = nextState->winDistance;
-    }
-    nextState = shallow->r;
-    if (nextState != nullptr && nextState->winDistance < winDistance) {
-      winDistance = nextState->winDistance;
-    }
-
-    if (winDistance + 1 < shallow->winDistance) {
-      shallow->winDistance = winDistance + 1;
-      endOfLoop = _explored2.Previous(); // If we come back around without making any progress, stop.
-    }
-
-    if (shallow == endOfLoop) break; // We just processed the last node, and it wasn't winning.
-
-    _explored2.Advance();
-  }
-}
-
-void Solver::DFSWinStates(State* state, u64 totalMillis, u16 backwardsMovements) {
-  if (state->shallow->winDistance == 0) {
-    if (totalMillis < _bestMillis
-     || (totalMillis == _bestMillis && backwardsMovements > _bestBackwardsMovements)) {
-      _bestSolution = _solution.Copy();
-      _bestMillis = totalMillis;
-      _bestBackwardsMovements = backwardsMovements;
-    }
-    return;
-  }
-
-  ComputePenaltyAndRecurse(state, state->u, Up, totalMillis, backwardsMovements);
-  ComputePenaltyAndRecurse(state, state->d, Down, totalMillis, backwardsMovements);
-  ComputePenaltyAndRecurse(state, state->l, Left, totalMillis, backwardsMovements);
-  ComputePenaltyAndRecurse(state, state->r, Right, totalMillis, backwardsMovements);
-}
-
-void Solver::ComputePenaltyAndRecurse(State* state, State* nextState, Direction dir, u64 totalMillis, u16 backwardsMovements) {
-  if (!nextState) return; // Move would be illegal
-  if (nextState->shallow->winDistance == UNWINNABLE) return; // Move is not ever winning
-  if (state->shallow->winDistance != nextState->shallow->winDistance + 1) return; // Move leads away from victory
-
-  // Compute the duration of this motion
-
-  // Speared state is not saved, because it's recoverable. Memory > speed tradeoff.
-  // This is gross. It gets a little cleaner if I can use for-each, but not much.
-  bool sausageSpeared = false;
-  if (state->stephen.HasFork()) {
-#define o(x) +1
-    for (u8 i=0; i<SAUSAGES; i++) {
-#undef o
-      const Sausage& sausage = state->sausages[i];
-      if (state->stephen.z != sausage.z) continue;
-      if ((state->stephen.x == sausage.x1 && state->stephen.y == sausage.y1)
-        || (state->stephen.x == sausage.x2 && state->stephen.y == sausage.y2)) {
-        sausageSpeared = true;
-        break;
-      }
-    }
-  }
-  if (!sausageSpeared) {
-    totalMillis += 160;
-
-#define o(x) if (state->sausages[x] != nextState->sausages[x]) totalMillis += 38;
-    SAUSAGES;
-#undef o
-  } else { // Movements are faster while spearing a sausage
-    totalMillis += 158;
-
-#define o(x) if (state->sausages[x] != nextState->sausages[x]) totalMillis += 4;
-    SAUSAGES;
-#undef o
-  }
-
-  if (WouldStephenStepOnGrill(state->stephen, dir)) totalMillis += 152; // TODO: Does this change while speared?
-  // TODO: Does the sausage movement cost depend on your *current state* or the *next state*? I.e. if you unspear and roll a sausage behind you, do you pay for it?
-  // TODO: Time sausage pushes as fork pushes (same latency as rotations?)
-  // TODO: Time motion w/ sausage hat
-  // TODO: Time motion w/ fork carry
-  // TODO: Time motion as forkless -> rotations *and* lateral motion
-  // TODO: Time motion when pushing a block
-  // TODO: Ladder climbs while speared / non-speared?
-
-  if (totalMillis > _bestMillis) return; // This solution is not faster than the known best path.
-
-  if (state->stephen.dir == Up && dir == Down)         backwardsMovements++;
-  else if (state->stephen.dir == Down && dir == Up)    backwardsMovements++;
-  else if (state->stephen.dir == Left && dir == Right) backwardsMovements++;
-  else if (state->stephen.dir == Right && dir == Left) backwardsMovements++;
-
-  _solution.Push(dir);
-  DFSWinStates(nextState, totalMillis, backwardsMovements);
-  _solution.Pop();
-}
-
-bool Solver::WouldStephenStepOnGrill(Stephen stephen, Direction dir) const {
-  if (dir == Up)         return _level->IsGrill(stephen.x, stephen.y - 1, stephen.z);
-  else if (dir == Down)  return _level->IsGrill(stephen.x, stephen.y + 1, stephen.z);
-  else if (dir == Left)  return _level->IsGrill(stephen.x - 1, stephen.y, stephen.z);
-  else if (dir == Right) return _level->IsGrill(stephen.x + 1, stephen.y, stephen.z);
-  assert(false);
-  return false;
-}
+#include "Solver.h"
+#include "Level.h"
+#include "GraphFile.h"
+#include "PageAllocator.h"
+#include <unordered_set>
+#include <unordered_map>
+#include <thread>
+#include <new>
+#include <queue>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+Solver::Solver(Level* level, const PruningProfile& pruning) : _pruning(level, pruning) {
+  _level = level;
+}
+
+Solver::~Solver() {
+  printf("Destroying _visitedNodes\n");
+}
+
+inline u16 PopCount16(u16 mask) {
+#if defined(_MSC_VER)
+  return __popcnt16(mask);
+#else
+  return (u16)__builtin_popcount(mask);
+#endif
+}
+
+u16 Score(State* state) {
+  u16 score = 0;
+  u16 sidesCooked;
+  u8 flags;
+#define o(x) { \
+    flags = state->GetSausage(x).flags; \
+    sidesCooked = (flags & Sausage::Flags::FullyCooked); \
+    if (sidesCooked == Sausage::Flags::FullyCooked) score += 100; \
+    else score += PopCount16(sidesCooked); \
+  }
+
+  SAUSAGES;
+#undef o
+  return score;
+}
+
+#if CUSTOM_GOAL
+// Edit this to solve for something other than finishing the level, e.g. setting up a specific position.
+bool IsCustomGoal(const State* state) {
+  Sausage sausage0 = state->GetSausage(0);
+  Sausage sausage1 = state->GetSausage(1);
+  return (state->stephen.x == 7 && state->stephen.y == 13 && state->stephen.dir == Up
+      && ((sausage0.x1 == 7 && sausage0.y1 == 9 && sausage1.x1 == 7 && sausage1.y1 == 11)
+          || (sausage1.x1 == 7 && sausage1.y1 == 9 && sausage0.x1 == 7 && sausage0.y1 == 11)));
+}
+#endif
+
+u16& Solver::GoalDistance(State* state, Goal goal) const {
+#if PARENT_POINTERS
+  return state->goalDistance[goal];
+#else
+  return state->shallow->goalDistance[goal];
+#endif
+}
+
+void Solver::InitGoalDistances(State* state) {
+#if PARENT_POINTERS
+  for (u16& distance : state->goalDistance) distance = UNWINNABLE;
+#else
+  state->shallow = _shallowAlloc.make<ShallowState>();
+#endif
+  u16 score = Score(state);
+  if (score > _bestScore) _bestScore = score;
+}
+
+Vector<Direction> Solver::Solve() {
+  printf("Solving %s\n", _level->name);
+  if (_memoryBudget == 0) _memoryBudget = DefaultMemoryBudget();
+
+  State* initialState;
+  if (_graphPath != nullptr && LoadGraph()) {
+    initialState = _explored[0];
+    printf("Loaded %zd nodes from %s\n", _visitedNodes2.Size(), _graphPath);
+  } else {
+    _visitedNodes2.CopyAdd(_level->GetState(), &initialState);
+    InitGoalDistances(initialState);
+    _frontier[0].Push(_explored.Size());
+    _explored.Push(initialState);
+
+    BFSStateGraph();
+
+    printf("Traversal done in %zd nodes.\n", _visitedNodes2.Size());
+    _pruning.PrintStats();
+    if (_tightPruning) _tightPruning->PrintStats();
+    // A graph file is keyed on the pruning profile, and this one was only partly built with it.
+    if (_graphPath != nullptr && _tightPruning) printf("Not saving the graph, since the pruning was tightened partway through.\n");
+    else if (_graphPath != nullptr) SaveGraph();
+  }
+#if BENCHMARK_STATE_SETS
+  BenchmarkStateSets(_explored);
+#endif
+
+  ComputeWinningStates();
+
+  u32 winningStates = 0;
+  for (State* state : _explored) {
+    if (WinDistance(state) != UNWINNABLE) winningStates++;
+  }
+
+  printf("Of the %zd nodes, %d are winning.\n", _visitedNodes2.Size(), winningStates);
+
+  _level->SetState(initialState); // Be polite and make sure we restore the original level state
+#if CUSTOM_GOAL
+  if (GoalDistance(initialState, CustomGoal) != UNWINNABLE) {
+    printf("Solving for the custom goal instead.\n");
+    _goal = CustomGoal;
+  } else {
+    printf("Could not reach the custom goal.\n");
+  }
+#endif
+  if (WinDistance(initialState) == UNWINNABLE) {
+    printf("Automatic solver could not find a solution.\n");
+    printf("Best score: %d\n", _bestScore);
+    _goal = ScoreGoal; // Already computed, alongside the distances to winning
+  }
+#if PARENT_POINTERS
+  else if (_goal == WinGoal) {
+    SeedBestSolution(_firstWinningState);
+  }
+#endif
+
+  if (_tightPruning) {
+    // The layers from _tightPruningDepth on are missing whatever the tighter pruning cut, which may include the best routes.
+    printf("Found a solution in %d moves, but it's not proven to be the shortest (the pruning was tightened from depth %d)\n",
+      WinDistance(initialState), _tightPruningDepth);
+  } else {
+    printf("Found the shortest # of moves: %d\n", WinDistance(initialState));
+  }
+  printf("Done computing victory states\n");
+
+#if PARENT_POINTERS
+  // GetSuccessor moves _level around (and inserts into _visitedNodes2), so this mode has to search serially.
+  ParallelDFSWinStates(initialState, 1);
+  _level->SetState(initialState);
+#else
+  u32 threads = TIMING_THREADS;
+  if (threads == 0) threads = std::thread::hardware_concurrency();
+  ParallelDFSWinStates(initialState, threads);
+#endif
+
+  s64 delta = _bestMillis - (_bestSolution.Size() * 160);
+  printf("Delta duration: %.03f seconds\n", delta / 1000.0);
+  printf("Solution duration: %lld.%03lld seconds\n", _bestMillis / 1000, _bestMillis % 1000);
+  if (_tightPruning) printf("Not proven optimal: some routes were pruned to stay within the memory budget.\n");
+
+  return _bestSolution.Copy();
+}
+
+void Solver::BFSStateGraph() {
+  u16 depth = 0;
+
+  while (true) {
+    Vector<u32>& currentLayer = _frontier[depth % 2];
+    Vector<u32>& nextLayer = _frontier[(depth + 1) % 2];
+
+    // Winning states never make it into the frontier (see GetOrInsertState), so everything here needs expanding.
+    for (u32 id : currentLayer) {
+      if (_memoryStage == MemoryStage::Truncated) break;
+      State* state = _explored[id];
+#if PARENT_POINTERS
+      _level->SetState(state);
+      if (_level->Move(Up))    GetOrInsertState(depth, id, Up);
+      _level->SetState(state);
+      if (_level->Move(Down))  GetOrInsertState(depth, id, Down);
+      _level->SetState(state);
+      if (_level->Move(Left))  GetOrInsertState(depth, id, Left);
+      _level->SetState(state);
+      if (_level->Move(Right)) GetOrInsertState(depth, id, Right);
+#else
+      _level->SetState(state);
+      if (_level->Move(Up))    state->u = GetOrInsertState(depth, id, Up);
+      _level->SetState(state);
+      if (_level->Move(Down))  state->d = GetOrInsertState(depth, id, Down);
+      _level->SetState(state);
+      if (_level->Move(Left))  state->l = GetOrInsertState(depth, id, Left);
+      _level->SetState(state);
+      if (_level->Move(Right)) state->r = GetOrInsertState(depth, id, Right);
+#endif
+    }
+    currentLayer.Resize(0);
+#if PARENT_POINTERS
+    // If we stopped partway through this layer, some of it was never expanded, so treat all of it that way.
+    _expandedDepth = (_memoryStage == MemoryStage::Truncated && depth > 0) ? depth - 1 : depth;
+#endif
+
+    printf("Finished processing depth %d, ", depth);
+    if (nextLayer.Size() == 0) {
+      printf("BFS exploration complete (no nodes remaining).\n");
+      break;
+    } else if (_memoryStage == MemoryStage::Truncated) {
+      printf("stopped partway through (out of memory).\n");
+      break;
+    } else if (_memoryStage == MemoryStage::LastLayer) {
+      printf("not exploring any further, since we're close to the memory budget.\n");
+      break;
+    } else if (depth == _winningDepth + 2) {
+      // I add a small fudge-factor here (2 iterations) to search for solutions
+      // which potentially take more moves, but are faster in realtime.
+      printf("not exploring any further, since the winning state was at depth %d.\n", _winningDepth);
+      break;
+    }
+
+    depth++;
+    printf("there are %d nodes to explore at depth %d\n", nextLayer.Size(), depth);
+  }
+}
+
+u64 Solver::GraphKey(const State& initialState) const {
+  // The starting state isn't always the level's initial state (we sometimes make a few moves before solving),
+  // and the pruning profile changes which states get explored, so both are part of the key too.
+  u64 hash = _level->DefinitionHash();
+  hash = HashBytes(hash, &initialState.stephen, sizeof(initialState.stephen));
+  for (s32 i=0; i<_level->SausageCount(); i++) {
+    Sausage sausage = initialState.GetSausage(i);
+    hash = HashBytes(hash, &sausage, sizeof(sausage));
+  }
+
+  const PruningProfile& profile = _pruning.Profile();
+  hash = HashBytes(hash, &profile.maxSausageDistance, sizeof(profile.maxSausageDistance));
+  hash = HashBytes(hash, &profile.walkingDistance, sizeof(profile.walkingDistance));
+  if (profile.regionMask != nullptr) hash = HashBytes(hash, profile.regionMask, strlen(profile.regionMask));
+  return hash;
+}
+
+bool Solver::LoadGraph() {
+  MappedFile file(_graphPath);
+  if (file.Data() == nullptr) return false; // Probably just doesn't exist yet
+
+  GraphFileHeader header;
+  if (file.Size() < sizeof(header)) return false;
+  memcpy(&header, file.Data(), sizeof(header));
+  State levelState = _level->GetState(); // The state we're solving from, which we also need to put back at the end
+  s32 sausageCount = _level->SausageCount();
+  size_t packedSize = sizeof(Stephen) + sausageCount * sizeof(Sausage);
+  if (memcmp(header.magic, "SSRG", 4) != 0
+    || header.engineVersion != ENGINE_VERSION
+    || header.key != GraphKey(levelState)
+    || header.nodeSize != sizeof(GraphFileNode)
+    || header.sausageCount != (u32)sausageCount
+    || file.Size() != sizeof(header) + header.nodeCount * (sizeof(GraphFileNode) + packedSize)) {
+    printf("Ignoring %s, since it was built for a different level, pruning profile, engine version, or build configuration\n", _graphPath);
+    return false;
+  }
+
+  const GraphFileNode* nodes = (const GraphFileNode*)(file.Data() + sizeof(header));
+  const u8* packed = (const u8*)(nodes + header.nodeCount);
+  // A damaged file can still be the right size, so check every ID before we use it as an index.
+  for (u32 id=0; id<header.nodeCount; id++) {
+#if PARENT_POINTERS
+    bool valid = (nodes[id].parent < header.nodeCount);
+#else
+    bool valid = true;
+    for (u32 child : nodes[id].children) valid &= (child == NO_NODE || child < header.nodeCount);
+#endif
+    if (!valid) {
+      printf("Ignoring %s, since node %d links to a node that isn't in the file\n", _graphPath, id);
+      return false;
+    }
+  }
+  Vector<Sausage> sausages;
+  sausages.Resize(sausageCount);
+  Stephen stephen;
+  for (u32 id=0; id<header.nodeCount; id++) {
+    // Round-tripping through the level gives us the exact same State (and hash) that the BFS would have.
+    memcpy(&stephen, packed, sizeof(Stephen));
+    memcpy(&sausages[0], packed + sizeof(Stephen), sausageCount * sizeof(Sausage));
+    packed += packedSize;
+    _level->SetState(stephen, &sausages[0]);
+
+    State* state;
+    if (!_visitedNodes2.CopyAdd(_level->GetState(), &state)) {
+      // Two IDs for the same state would make the edges ambiguous, so the file must be damaged.
+      printf("Ignoring %s, since node %d is a duplicate of an earlier node\n", _graphPath, id);
+      ForgetGraph();
+      _level->SetState(&levelState);
+      return false;
+    }
+    InitGoalDistances(state);
+#if PARENT_POINTERS
+    state->parent = nodes[id].parent;
+    state->depth = nodes[id].depth;
+    state->move = nodes[id].move;
+    if (nodes[id].winDistance == 0 && _firstWinningState == nullptr) _firstWinningState = state;
+#endif
+    GoalDistance(state, WinGoal) = nodes[id].winDistance;
+    _explored.Push(state);
+  }
+
+#if !PARENT_POINTERS
+  // Now that every node exists, we can hook up the edges.
+  for (u32 id=0; id<header.nodeCount; id++) {
+    State* state = _explored[id];
+    const u32* children = nodes[id].children;
+    if (children[0] != NO_NODE) state->u = _explored[children[0]];
+    if (children[1] != NO_NODE) state->d = _explored[children[1]];
+    if (children[2] != NO_NODE) state->l = _explored[children[2]];
+    if (children[3] != NO_NODE) state->r = _explored[children[3]];
+  }
+#else
+  _expandedDepth = header.expandedDepth;
+#endif
+  _winningDepth = header.winningDepth;
+
+  _level->SetState(&levelState);
+  return true;
+}
+
+void Solver::ForgetGraph() {
+  // Neither kind of set can be emptied in place, so just make a new one.
+  using VisitedSet = decltype(_visitedNodes2);
+  _visitedNodes2.~VisitedSet();
+  new (&_visitedNodes2) VisitedSet(0x7FFFFF);
+  _explored.Resize(0);
+  _bestScore = 0;
+#if PARENT_POINTERS
+  _firstWinningState = nullptr;
+#endif
+  // The ShallowStates stay in _shallowAlloc until we're done, which is no worse than a graph that loaded.
+}
+
+void Solver::SaveGraph() {
+  FILE* file = fopen(_graphPath, "wb");
+  if (file == nullptr) {
+    printf("Could not open %s to save the graph\n", _graphPath);
+    return;
+  }
+
+  GraphFileHeader header;
+  memcpy(header.magic, "SSRG", 4);
+  header.engineVersion = ENGINE_VERSION;
+  header.key = GraphKey(*_explored[0]);
+  header.nodeSize = sizeof(GraphFileNode);
+  header.sausageCount = _level->SausageCount();
+  header.nodeCount = _explored.Size();
+  header.winningDepth = _winningDepth;
+#if PARENT_POINTERS
+  header.expandedDepth = _expandedDepth;
+#else
+  header.expandedDepth = 0;
+#endif
+  fwrite(&header, sizeof(header), 1, file);
+
+#if !PARENT_POINTERS
+  // Edges are pointers in memory, so we need a way back to node IDs.
+  std::unordered_map<const State*, u32> ids;
+  for (u32 id=0; id<(u32)_explored.Size(); id++) ids[_explored[id]] = id;
+  auto idOf = [&](const State* state) { return state == nullptr ? NO_NODE : ids[state]; };
+#endif
+
+  for (State* state : _explored) {
+    GraphFileNode node;
+#if PARENT_POINTERS
+    node.parent = state->parent;
+    node.depth = state->depth;
+    node.move = state->move;
+#else
+    node.children[0] = idOf(state->u);
+    node.children[1] = idOf(state->d);
+    node.children[2] = idOf(state->l);
+    node.children[3] = idOf(state->r);
+#endif
+    node.winDistance = GoalDistance(state, WinGoal);
+    fwrite(&node, sizeof(node), 1, file);
+  }
+
+  for (State* state : _explored) {
+    fwrite(&state->stephen, sizeof(Stephen), 1, file);
+    for (s32 i=0; i<_level->SausageCount(); i++) {
+      Sausage sausage = state->GetSausage(i);
+      fwrite(&sausage, sizeof(Sausage), 1, file);
+    }
+  }
+
+  fclose(file);
+  printf("Saved the graph to %s\n", _graphPath);
+}
+
+State* Solver::GetOrInsertState(u16 depth, u32 parent, Direction dir) {
+  State* state;
+#if FLAT_HASH_SET
+  // Most successors are duplicates (at least once the BFS gets going), and this way those never build a State.
+  if (!PruningFor(depth).Allows(*_explored[parent], *_level)) return nullptr;
+  bool inserted = _visitedNodes2.LevelAdd(*_level, &state);
+#else
+  State nextState = _level->GetState();
+  if (!PruningFor(depth).Allows(*_explored[parent], nextState)) return nullptr;
+  bool inserted = _visitedNodes2.CopyAdd(nextState, &state);
+#endif
+  if (!inserted) return state; // State was already analyzed, or allocation failed
+
+  if (_visitedNodes2.Size() % 100'000 == 0) {
+    //_level->Print();
+  }
+
+  InitGoalDistances(state);
+#if PARENT_POINTERS
+  state->parent = parent;
+  state->depth = depth + 1;
+  state->move = dir;
+#endif
+
+  // Since we're a BFS, appending here keeps _explored in depth-sorted order.
+  u32 id = _explored.Size();
+  _explored.Push(state);
+  if ((id & 0xFFFF) == 0) CheckMemoryBudget(depth);
+
+  if (_level->Won()) {
+      GoalDistance(state, WinGoal) = 0;
+      if (_winningDepth == UNWINNABLE) {
+        // Once we find a winning state, we have reached the minimum depth for a solution.
+        // Ergo, we should not explore the tree deeper than that solution. Since we're a BFS,
+        // that means we should finish the current depth, but not explore any further.
+        _winningDepth = depth + 1; // +1 because the winning move is at the *next* depth, not the current one.
+        printf("Found the first winning state at depth %d!\n", _winningDepth);
+#if PARENT_POINTERS
+        _firstWinningState = state;
+#endif
+      }
+      return state; // There's no need to explore past a winning state.
+  }
+
+  _frontier[(depth + 1) % 2].Push(id);
+  return state;
+}
+
+size_t Solver::MemoryUsed() const {
+#if FLAT_HASH_SET
+  size_t bytes = _visitedNodes2.BytesUsed();
+#else
+  // NodeHashSet allocates each state separately, and (roughly) adds a bucket pointer and a next pointer.
+  size_t bytes = _visitedNodes2.Size() * (sizeof(State) + 2 * sizeof(void*));
+#endif
+#if !PARENT_POINTERS
+  bytes += _visitedNodes2.Size() * sizeof(ShallowState);
+#endif
+  bytes += _explored.Size() * sizeof(State*);
+  bytes += (_frontier[0].Size() + _frontier[1].Size()) * sizeof(u32);
+  return bytes;
+}
+
+void Solver::CheckMemoryBudget(u16 depth) {
+  // Each stage is only entered (and logged) once, and we never go back.
+  size_t used = MemoryUsed();
+  // Stopping early loses the deeper layers entirely, so first try to make them smaller.
+  if (_memoryStage == MemoryStage::Normal && used > _memoryBudget / 4 && TightenPruning(depth)) {
+    _memoryStage = MemoryStage::Tightened;
+    printf("\nUsing %.2f GB of the %.2f GB budget, so depth %d onwards will only go %d units from a sausage.\n",
+      used / 1e9, _memoryBudget / 1e9, depth + 1, _tightPruning->Profile().maxSausageDistance);
+  }
+  // The layer we're building can easily be as big as everything before it, so this is the time to stop adding layers.
+  if ((_memoryStage == MemoryStage::Normal || _memoryStage == MemoryStage::Tightened) && used > _memoryBudget / 2) {
+    _memoryStage = MemoryStage::LastLayer;
+    printf("\nUsing %.2f GB of the %.2f GB budget (%zd states, %.0f bytes each), so depth %d will be the last one.\n",
+      used / 1e9, _memoryBudget / 1e9, _visitedNodes2.Size(), (double)used / _visitedNodes2.Size(), depth + 1);
+#if !PARENT_POINTERS
+    printf("To go deeper, try PARENT_POINTERS 1 (which drops the edges and shallow states), or HASH_COMPACTION 1.\n");
+#elif !HASH_COMPACTION
+    printf("To go deeper, try HASH_COMPACTION 1 (which only keeps a fingerprint of each state).\n");
+#endif
+  }
+  // IDs are u32s, so that's a hard limit regardless of the budget.
+  if (_memoryStage != MemoryStage::Truncated && (used > _memoryBudget || _visitedNodes2.Size() > 0xF0000000)) {
+    _memoryStage = MemoryStage::Truncated;
+    printf("\nUsing %.2f GB of the %.2f GB budget, so we're stopping partway through depth %d.\n",
+      used / 1e9, _memoryBudget / 1e9, depth + 1);
+  }
+}
+
+bool Solver::TightenPruning(u16 depth) {
+  if (_keepPruning) return false;
+  // Pruning which is already this tight cuts optimal routes on plenty of levels (see GetPruningProfile), so don't go further.
+  PruningProfile profile = _pruning.Profile();
+  if (profile.maxSausageDistance == 0) profile.maxSausageDistance = 4;
+  else if (profile.maxSausageDistance > 2) profile.maxSausageDistance = 2;
+  else return false;
+
+  // The layer being built right now is the first one we'll expand with it.
+  _tightPruning = std::make_unique<Pruning>(_level, profile);
+  _tightPruningDepth = depth + 1;
+  return true;
+}
+
+#if PARENT_POINTERS
+State* Solver::GetSuccessor(const State* state, Direction dir) {
+  _level->SetState(state);
+  if (!_level->Move(dir)) return nullptr;
+  if (!PruningFor(state->depth).Allows(*state, *_level, false)) return nullptr; // Already counted during the BFS
+
+  State* nextState;
+#if FLAT_HASH_SET
+  bool inserted = _visitedNodes2.LevelAdd(*_level, &nextState);
+#else
+  bool inserted = _visitedNodes2.CopyAdd(_level->GetState(), &nextState);
+#endif
+  assert(!inserted); // Every successor of an expanded state was already inserted during the BFS.
+  return nextState;
+}
+
+void Solver::ComputeWinningStates() {
+  printf("Computing winning states to achieve the best score\n");
+
+  // Without edges, we have to recompute every state's successors. To keep that to a single pass, we only consider moves
+  // which go exactly one layer deeper -- by walking _explored backwards, those successors are always finalized first.
+  // This is sufficient: any move-optimal path from the initial state visits each depth in turn, and DFSWinStates only
+  // ever follows move-optimal paths.
+  // Every goal is computed in the same pass, since recomputing the successors is the expensive part.
+  for (u32 id = _explored.Size(); id > 0; id--) {
+    State* state = _explored[id - 1];
+    if (Score(state) == _bestScore) state->goalDistance[ScoreGoal] = 0;
+#if CUSTOM_GOAL
+    if (IsCustomGoal(state)) state->goalDistance[CustomGoal] = 0;
+#endif
+    if (state->goalDistance[WinGoal] == 0) continue; // Winning states are never expanded
+    if (state->depth > _expandedDepth) continue; // Neither are the states past the end of the BFS
+
+    for (Direction dir : {Up, Down, Left, Right}) {
+      State* nextState = GetSuccessor(state, dir);
+      if (nextState == nullptr || nextState->depth != state->depth + 1) continue;
+      for (u8 goal=0; goal<GOAL_COUNT; goal++) {
+        if (nextState->goalDistance[goal] + 1 < state->goalDistance[goal]) state->goalDistance[goal] = nextState->goalDistance[goal] + 1;
+      }
+    }
+  }
+}
+
+void Solver::SeedBestSolution(State* winningState) {
+  Vector<State*> path;
+  for (State* state = winningState; state != _explored[0]; state = _explored[state->parent]) path.Push(state);
+  path.Push(_explored[0]);
+
+  // |path| runs from the winning state back to the initial state, so we replay it in reverse.
+  u64 totalMillis = 0;
+  u16 backwardsMovements = 0;
+  for (s32 i = path.Size() - 1; i > 0; i--) {
+    State* state = path[i];
+    Direction dir = path[i - 1]->move;
+    totalMillis += ComputeMoveMillis(_level, state, path[i - 1], dir);
+    if (IsBackwardsMovement(state->stephen.dir, dir)) backwardsMovements++;
+    _bestSolution.Push(dir);
+  }
+  _bestMillis = totalMillis;
+  _bestBackwardsMovements = backwardsMovements;
+  printf("Walking parents found a %d move solution which takes %lld.%03lld seconds\n", _bestSolution.Size(), _bestMillis / 1000, _bestMillis % 1000);
+}
+#else
+void Solver::CreateShallowStates() {
+  _explored2 = LinkedLoop<ShallowState>(); // Clear the shallow state list in case we're re-evaluating after failing to win.
+
+  // Second iteration because we need shallow copies of the udlr states. (maybe not?)
+  printf("Populating shallow states:                                                                          |\n");
+  for (State* state : _explored) {
+    ShallowState* shallow = state->shallow;
+    // This is the last time we look at the full states, so this is where the other goals get seeded.
+    if (Score(state) == _bestScore) shallow->goalDistance[ScoreGoal] = 0;
+#if CUSTOM_GOAL
+    if (IsCustomGoal(state)) shallow->goalDistance[CustomGoal] = 0;
+#endif
+    if (state->u) shallow->u = state->u->shallow;
+    if (state->d) shallow->d = state->d->shallow;
+    if (state->l) shallow->l = state->l->shallow;
+    if (state->r) shallow->r = state->r->shallow;
+    _explored2.AddCurrent(shallow);
+    if (_explored.Size() >= 100 && _explored2.Size() % (_explored.Size() / 100) == 0) printf("#"); // Tiny levels get no progress bar
+  }
+
+  printf("|\n");
+}
+
+void Solver::ComputeWinningStates() {
+  /* Even though we generate the list in order, we should not remove states from the loop, and we may need to do multiple loops.
+     For example, consider this graph: A is at depth 0, B and D are at 1, C is at 2.
+     A -> (D)
+       \v   ^\
+         B -> C
+
+    Although C->D is a sub-optimal move (depth is decreasing), C is still a winning state. Since we process in depth order,
+    we will process C, D, B, A -- ergo when we check D the first time it won't be marked winning.
+    But, we do still want to mark C as winning -- since we haven't *truly* computed the costs yet, we don't know if it's faster.
+  */
+
+  // Reducing the memory required to represent the tree by removing sausages positions from State.
+  // This helps to avoid paging with very large trees.
+  CreateShallowStates();
+
+  printf("Computing winning states to achieve the best score\n");
+
+  // If (somehow) we make it through the entire loop and find no win states, this is the correct exit condition.
+  // It is very likely that this value will be updated during iteration.
+  ShallowState* endOfLoop = _explored2.Previous();
+
+  while (true) {
+    ShallowState* shallow = _explored2.Current();
+    if (shallow == nullptr) break; // All states are winning
+
+    // All of the goals are relaxed together, so one loop covers them all.
+    bool progress = false;
+    for (u8 goal=0; goal<GOAL_COUNT; goal++) {
+      u16 distance = shallow->goalDistance[goal];
+
+      ShallowState* nextState = shallow->u;
+      if (nextState != nullptr && nextState->goalDistance[goal] < distance) {
+        distance = nextState->goalDistance[goal];
+      }
+      nextState = shallow->d;
+      if (nextState != nullptr && nextState->goalDistance[goal] < distance) {
+        distance = nextState->goalDistance[goal];
+      }
+      nextState = shallow->l;
+      if (nextState != nullptr && nextState->goalDistance[goal] < distance) {
+        distance = nextState->goalDistance[goal];
+      }
+      nextState = shallow->r;
+      if (nextState != nullptr && nextState->goalDistance[goal] < distance) {
+        distance = nextState->goalDistance[goal];
+      }
+
+      if (distance + 1 < shallow->goalDistance[goal]) {
+        shallow->goalDistance[goal] = distance + 1;
+        progress = true;
+      }
+    }
+    if (progress) {
+      endOfLoop = _explored2.Previous(); // If we come back around without making any progress, stop.
+    }
+
+    if (shallow == endOfLoop) break; // We just processed the last node, and it wasn't winning.
+
+    _explored2.Advance();
+  }
+}
+#endif
+
+void Solver::SplitTimingSearch(State* initialState, s32 minTasks, Vector<TimingTask>& tasks, Vector<Direction>& moves) {
+  // Same idea as the BFS frontier: expand every task by one move, and alternate between the two buffers.
+  Vector<TimingTask> generations[2];
+  Vector<Direction> generationMoves[2];
+  generations[0].Push({initialState, 0, 0, 0, 0});
+
+  u32 g = 0;
+  while (generations[g].Size() < minTasks) {
+    Vector<TimingTask>& nextTasks = generations[(g + 1) % 2];
+    Vector<Direction>& nextMoves = generationMoves[(g + 1) % 2];
+    nextTasks.Resize(0);
+    nextMoves.Resize(0);
+    bool expanded = false;
+
+    for (const TimingTask& task : generations[g]) {
+      // Push a task, along with the moves to reach it, plus |dir| if it's not None.
+      auto pushTask = [&](State* state, u64 totalMillis, u16 backwardsMovements, Direction dir) {
+        TimingTask nextTask = {state, totalMillis, backwardsMovements, (u32)nextMoves.Size(), task.movesLength};
+        for (u16 i=0; i<task.movesLength; i++) nextMoves.Push(generationMoves[g][task.movesStart + i]);
+        if (dir != None) {
+          nextMoves.Push(dir);
+          nextTask.movesLength++;
+        }
+        nextTasks.Push(nextTask);
+      };
+
+      State* state = task.state;
+      if (WinDistance(state) == 0) { // Nothing to expand, this task is just a solution.
+        pushTask(state, task.totalMillis, task.backwardsMovements, None);
+        continue;
+      }
+
+#if PARENT_POINTERS
+      State* children[] = {GetSuccessor(state, Up), GetSuccessor(state, Down), GetSuccessor(state, Left), GetSuccessor(state, Right)};
+#else
+      State* children[] = {state->u, state->d, state->l, state->r};
+#endif
+      const Direction dirs[] = {Up, Down, Left, Right};
+      for (s32 i=0; i<4; i++) {
+        // Same checks as ComputePenaltyAndRecurse
+        State* nextState = children[i];
+        if (!nextState) continue;
+        if (WinDistance(nextState) == UNWINNABLE) continue;
+        if (WinDistance(state) != WinDistance(nextState) + 1) continue;
+
+        u64 totalMillis = task.totalMillis + ComputeMoveMillis(_level, state, nextState, dirs[i]);
+        if (totalMillis > _bestMillis) continue;
+        u16 backwardsMovements = task.backwardsMovements;
+        if (IsBackwardsMovement(state->stephen.dir, dirs[i])) backwardsMovements++;
+
+        pushTask(nextState, totalMillis, backwardsMovements, dirs[i]);
+        expanded = true;
+      }
+    }
+
+    g = (g + 1) % 2;
+    if (!expanded) break; // Every task is already a solution
+  }
+
+  tasks = generations[g].Copy();
+  moves = generationMoves[g].Copy();
+}
+
+void Solver::ParallelDFSWinStates(State* initialState, u32 threads) {
+  if (threads < 1) threads = 1;
+  _sharedBestMillis = _bestMillis; // In case SeedBestSolution already found something
+
+  Vector<TimingTask> tasks;
+  Vector<Direction> moves;
+  if (threads == 1) {
+    tasks.Push({initialState, 0, 0, 0, 0});
+  } else {
+    // Plenty of small tasks, since the subtrees are very uneven (and most of them get pruned quickly).
+    SplitTimingSearch(initialState, threads * 64, tasks, moves);
+    printf("Searching for the fastest solution on %d threads (%d tasks)\n", threads, tasks.Size());
+  }
+
+  // Workers grab the next task whenever they finish one, so each worker sees its tasks in increasing order.
+  std::atomic<u32> nextTask{0};
+  TimingSearch* searches = new TimingSearch[threads];
+  auto worker = [&](TimingSearch* search) {
+    search->bestMillis = _bestMillis;
+    search->bestBackwardsMovements = _bestBackwardsMovements;
+    while (true) {
+      u32 task = nextTask++;
+      if (task >= (u32)tasks.Size()) break;
+      search->task = task;
+      search->solution.Resize(0);
+      for (u16 i=0; i<tasks[task].movesLength; i++) search->solution.Push(moves[tasks[task].movesStart + i]);
+      DFSWinStates(*search, tasks[task].state, tasks[task].totalMillis, tasks[task].backwardsMovements);
+    }
+  };
+
+  if (threads == 1) {
+    worker(&searches[0]);
+  } else {
+    std::vector<std::thread> pool;
+    for (u32 i=0; i<threads; i++) pool.emplace_back(worker, &searches[i]);
+    for (std::thread& thread : pool) thread.join();
+  }
+
+  // Pick the same solution that a serial DFS would: fastest, then most backwards movements, then whichever came first.
+  // Anything which ties with a seeded solution loses to it, since the serial DFS would never have replaced it either.
+  u32 bestTask = 0;
+  for (u32 i=0; i<threads; i++) {
+    const TimingSearch& search = searches[i];
+    if (search.bestMillis < _bestMillis
+     || (search.bestMillis == _bestMillis && search.bestBackwardsMovements > _bestBackwardsMovements)
+     || (search.bestMillis == _bestMillis && search.bestBackwardsMovements == _bestBackwardsMovements && search.bestTask < bestTask)) {
+      _bestSolution = search.bestSolution.Copy();
+      _bestMillis = search.bestMillis;
+      _bestBackwardsMovements = search.bestBackwardsMovements;
+      bestTask = search.bestTask;
+    }
+  }
+  delete[] searches;
+}
+
+void Solver::DFSWinStates(TimingSearch& search, State* state, u64 totalMillis, u16 backwardsMovements) {
+  if (WinDistance(state) == 0) {
+    if (totalMillis < search.bestMillis
+     || (totalMillis == search.bestMillis && backwardsMovements > search.bestBackwardsMovements)) {
+      search.bestSolution = search.solution.Copy();
+      search.bestMillis = totalMillis;
+      search.bestBackwardsMovements = backwardsMovements;
+      search.bestTask = search.task;
+
+      // Let the other workers know, so that they can prune against it.
+      u64 sharedBest = _sharedBestMillis.load();
+      while (totalMillis < sharedBest && !_sharedBestMillis.compare_exchange_weak(sharedBest, totalMillis)) {}
+    }
+    return;
+  }
+
+#if PARENT_POINTERS
+  ComputePenaltyAndRecurse(search, state, GetSuccessor(state, Up), Up, totalMillis, backwardsMovements);
+  ComputePenaltyAndRecurse(search, state, GetSuccessor(state, Down), Down, totalMillis, backwardsMovements);
+  ComputePenaltyAndRecurse(search, state, GetSuccessor(state, Left), Left, totalMillis, backwardsMovements);
+  ComputePenaltyAndRecurse(search, state, GetSuccessor(state, Right), Right, totalMillis, backwardsMovements);
+#else
+  ComputePenaltyAndRecurse(search, state, state->u, Up, totalMillis, backwardsMovements);
+  ComputePenaltyAndRecurse(search, state, state->d, Down, totalMillis, backwardsMovements);
+  ComputePenaltyAndRecurse(search, state, state->l, Left, totalMillis, backwardsMovements);
+  ComputePenaltyAndRecurse(search, state, state->r, Right, totalMillis, backwardsMovements);
+#endif
+}
+
+void Solver::ComputePenaltyAndRecurse(TimingSearch& search, State* state, State* nextState, Direction dir, u64 totalMillis, u16 backwardsMovements) {
+  if (!nextState) return; // Move would be illegal
+  if (WinDistance(nextState) == UNWINNABLE) return; // Move is not ever winning
+  if (WinDistance(state) != WinDistance(nextState) + 1) return; // Move leads away from victory
+
+  totalMillis += ComputeMoveMillis(_level, state, nextState, dir);
+  // This solution is not faster than the known best path. Ties have to keep going, since they might have more backwards movements.
+  if (totalMillis > search.bestMillis || totalMillis > _sharedBestMillis.load(std::memory_order_relaxed)) return;
+
+  if (IsBackwardsMovement(state->stephen.dir, dir)) backwardsMovements++;
+
+  search.solution.Push(dir);
+  DFSWinStates(search, nextState, totalMillis, backwardsMovements);
+  search.solution.Pop();
+}
+
+// Packs a move's duration and whether it was a backwards movement into a single cost, so that sorting by total cost sorts by
+// duration and then by *most* backwards movements (the same tiebreakers as DFSWinStates). Good for up to 65535 moves.
+inline u64 AlternativeCost(u64 millis, bool backwards) {
+  return (millis << 16) - (backwards ? 1 : 0);
+}
+
+u64 Solver::RemainingCost(State* state, std::unordered_map<State*, u64>& memo) {
+  if (WinDistance(state) == 0) return 0;
+  auto it = memo.find(state);
+  if (it != memo.end()) return it->second;
+
+#if PARENT_POINTERS
+  State* children[] = {GetSuccessor(state, Up), GetSuccessor(state, Down), GetSuccessor(state, Left), GetSuccessor(state, Right)};
+#else
+  State* children[] = {state->u, state->d, state->l, state->r};
+#endif
+  const Direction dirs[] = {Up, Down, Left, Right};
+  u64 bestCost = (u64)-1;
+  for (s32 i=0; i<4; i++) {
+    State* nextState = children[i];
+    if (!nextState) continue;
+    if (WinDistance(nextState) == UNWINNABLE) continue;
+    if (WinDistance(state) != WinDistance(nextState) + 1) continue;
+
+    u64 millis = ComputeMoveMillis(_level, state, nextState, dirs[i]);
+    u64 cost = AlternativeCost(millis, IsBackwardsMovement(state->stephen.dir, dirs[i])) + RemainingCost(nextState, memo);
+    if (cost < bestCost) bestCost = cost;
+  }
+
+  memo[state] = bestCost;
+  return bestCost;
+}
+
+void Solver::FindAlternatives(u32 count, Vector<Direction>& moves, Vector<u64>& millis) {
+  moves.Resize(0);
+  millis.Resize(0);
+  State* initialState = _explored[0];
+  if (WinDistance(initialState) == UNWINNABLE) return;
+
+  // Since we know exactly what the cheapest route from every state costs (RemainingCost), a best-first search over
+  // partial solutions pops complete solutions in order of cost -- and never pops anything that can't finish within
+  // the cost of the count'th solution. Each partial solution is a distinct list of moves, so each result is distinct.
+  struct Partial {
+    State* state;
+    u32 parent; // Index into |partials|
+    Direction dir;
+    u64 cost; // So far
+    u64 millis; // So far
+  };
+  struct QueueEntry {
+    u64 totalCost; // Estimated, but the estimate is exact
+    u64 cost;
+    u32 partial;
+    bool operator<(const QueueEntry& other) const { // Reversed, so that the queue pops the cheapest entry
+      if (totalCost != other.totalCost) return totalCost > other.totalCost;
+      return cost < other.cost; // Among ties, prefer the one which is further along, so that we finish it.
+    }
+  };
+
+  std::unordered_map<State*, u64> memo;
+  Vector<Partial> partials;
+  std::priority_queue<QueueEntry> queue;
+  partials.Push({initialState, 0, None, 0, 0});
+  queue.push({RemainingCost(initialState, memo), 0, 0});
+
+  u16 length = WinDistance(initialState);
+  Vector<Direction> solution;
+  solution.Resize(length);
+  while (!queue.empty() && (u32)millis.Size() < count) {
+    QueueEntry entry = queue.top();
+    queue.pop();
+    Partial partial = partials[entry.partial];
+    State* state = partial.state;
+
+    if (WinDistance(state) == 0) {
+      // Walk back up the parents to recover the moves
+      u32 i = length;
+      for (u32 id = entry.partial; id != 0; id = partials[id].parent) solution[--i] = partials[id].dir;
+      for (Direction dir : solution) moves.Push(dir);
+      millis.Push(partial.millis);
+      continue;
+    }
+
+#if PARENT_POINTERS
+    State* children[] = {GetSuccessor(state, Up), GetSuccessor(state, Down), GetSuccessor(state, Left), GetSuccessor(state, Right)};
+#else
+    State* children[] = {state->u, state->d, state->l, state->r};
+#endif
+    const Direction dirs[] = {Up, Down, Left, Right};
+    for (s32 i=0; i<4; i++) {
+      State* nextState = children[i];
+      if (!nextState) continue;
+      if (WinDistance(nextState) == UNWINNABLE) continue;
+      if (WinDistance(state) != WinDistance(nextState) + 1) continue;
+
+      u64 millis = ComputeMoveMillis(_level, state, nextState, dirs[i]);
+      u64 cost = partial.cost + AlternativeCost(millis, IsBackwardsMovement(state->stephen.dir, dirs[i]));
+      queue.push({cost + RemainingCost(nextState, memo), cost, (u32)partials.Size()});
+      partials.Push({nextState, entry.partial, dirs[i], cost, partial.millis + millis});
+    }
+  }
+
+  printf("Found %d alternative solutions (searched %d partial solutions)\n", millis.Size(), partials.Size());
+#if PARENT_POINTERS
+  _level->SetState(initialState); // GetSuccessor moves the level around
+#endif
+}
+
+bool Solver::ReplaySolution(Level* level, const State& initialState, const Vector<Direction>& moves, u64* millis, s32* failedMove) {
+  *millis = 0;
+  if (failedMove != nullptr) *failedMove = -1;
+  bool won = true;
+  level->SetState(&initialState);
+  for (s32 i=0; i<moves.Size(); i++) {
+    State state = level->GetState();
+    if (!level->Move(moves[i])) {
+      if (failedMove != nullptr) *failedMove = i;
+      won = false;
+      break;
+    }
+    State nextState = level->GetState();
+    *millis += ComputeMoveMillis(level, &state, &nextState, moves[i]);
+  }
+  if (won && !level->Won()) won = false;
+  level->SetState(&initialState);
+  return won;
+}
+
+u64 Solver::ComputeMoveMillis(const Level* level, const State* state, const State* nextState, Direction dir) {
+  u64 millis = 0;
+
+  // Speared state is not saved, because it's recoverable. Memory > speed tradeoff.
+  // This is gross. It gets a little cleaner if I can use for-each, but not much.
+  bool sausageSpeared = false;
+  if (state->stephen.HasFork()) {
+#define o(x) +1
+    for (u8 i=0; i<SAUSAGES; i++) {
+#undef o
+      Sausage sausage = state->GetSausage(i);
+      if (state->stephen.z != sausage.z) continue;
+      if ((state->stephen.x == sausage.x1 && state->stephen.y == sausage.y1)
+        || (state->stephen.x == sausage.x2 && state->stephen.y == sausage.y2)) {
+        sausageSpeared = true;
+        break;
+      }
+    }
+  }
+  if (!sausageSpeared) {
+    millis += 160;
+
+#define o(x) if (state->GetSausage(x) != nextState->GetSausage(x)) millis += 38;
+    SAUSAGES;
+#undef o
+  } else { // Movements are faster while spearing a sausage
+    millis += 158;
+
+#define o(x) if (state->GetSausage(x) != nextState->GetSausage(x)) millis += 4;
+    SAUSAGES;
+#undef o
+  }
+
+  if (WouldStephenStepOnGrill(level, state->stephen, dir)) millis += 152; // TODO: Does this change while speared?
+  // TODO: Does the sausage movement cost depend on your *current state* or the *next state*? I.e. if you unspear and roll a sausage behind you, do you pay for it?
+  // TODO: Time sausage pushes as fork pushes (same latency as rotations?)
+  // TODO: Time motion w/ sausage hat
+  // TODO: Time motion w/ fork carry
+  // TODO: Time motion as forkless -> rotations *and* lateral motion
+  // TODO: Time motion when pushing a block
+  // TODO: Ladder climbs while speared / non-speared?
+
+  return millis;
+}
+
+bool Solver::WouldStephenStepOnGrill(const Level* level, Stephen stephen, Direction dir) {
+  if (dir == Up)         return level->IsGrill(stephen.x, stephen.y - 1, stephen.z);
+  else if (dir == Down)  return level->IsGrill(stephen.x, stephen.y + 1, stephen.z);
+  else if (dir == Left)  return level->IsGrill(stephen.x - 1, stephen.y, stephen.z);
+  else if (dir == Right) return level->IsGrill(stephen.x + 1, stephen.y, stephen.z);
+  assert(false);
+  return false;
+}
+
+bool Solver::IsBackwardsMovement(Direction facing, Direction dir) {
+  if (facing == Up && dir == Down)         return true;
+  else if (facing == Down && dir == Up)    return true;
+  else if (facing == Left && dir == Right) return true;
+  else if (facing == Right && dir == Left) return true;
+  return false;
+}
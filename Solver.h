@@ -1,35 +1,148 @@
-#pragma once
-#include "Level.h"
-#include "WitnessRNG/StdLib.h"
-
-struct Solver {
-  Solver(Level* level);
-  ~Solver();
-
-  Vector<Direction> Solve();
-
-private:
-  void BFSStateGraph();
-  State* GetOrInsertState(u16 depth);
-
-  void CreateShallowStates();
-  void ComputeWinningStates();
-
-  void DFSWinStates(State* state, u64 totalMillis, u16 backwardsMovements);
-  void ComputePenaltyAndRecurse(State* state, State* nextState, Direction dir, u64 totalMillis, u16 backwardsMovements);
-  bool WouldStephenStepOnGrill(Stephen stephen, Direction dir) const;
-
-  Level* _level = nullptr;
-  NodeHashSet<State> _visitedNodes2 = NodeHashSet<State>(0x7FFFFF); // Choose a relatively large initial size because we'll need it.
-  u16 _winningDepth = UNWINNABLE;
-  LinkedList<State> _unexplored;
-  LinkedList<State> _explored;
-
-  LinearAllocator _shallowAlloc;
-  LinkedLoop<ShallowState> _explored2;
-
-  Vector<Direction> _solution;
-  Vector<Direction> _bestSolution;
-  u64 _bestMillis = (u64)-1;
-  u16 _bestBackwardsMovements = 0;
-};
+#pragma once
+#include "Level.h"
+#include "Pruning.h"
+#include "StateSet.h"
+#include "WitnessRNG/StdLib.h"
+#include <atomic>
+#include <memory>
+#include <unordered_map>
+
+// How far along |state| is: 100 for each fully cooked sausage, plus one for each cooked side of the others.
+u16 Score(State* state);
+
+struct Solver {
+  Solver(Level* level, const PruningProfile& pruning = {});
+  ~Solver();
+
+  Vector<Direction> Solve();
+
+  // Load the explored graph from |path| if it was built for this level (and engine version, and pruning profile),
+  // otherwise run the BFS as normal and save the result there.
+  inline void UseGraphFile(const char* path) { _graphPath = path; }
+  // The most memory the graph may use, in bytes. 0 (the default) means 3/4 of the machine's RAM.
+  // See CheckMemoryBudget for what happens as the BFS gets close to it.
+  inline void SetMemoryBudget(size_t bytes) { _memoryBudget = bytes; }
+  // Never tighten the pruning to save memory (see CheckMemoryBudget), e.g. when the profile was picked to verify a result.
+  // Running low on memory then goes straight to stopping the BFS early.
+  inline void KeepPruning() { _keepPruning = true; }
+
+  // Call after Solve. Finds the |count| fastest move-optimal solutions (including the best one) in ascending duration,
+  // using the graph which Solve already built. They all have the same number of moves, so they're stored back-to-back in
+  // |moves|, and |millis| has one entry per solution.
+  void FindAlternatives(u32 count, Vector<Direction>& moves, Vector<u64>& millis);
+
+  // The timing model: how long (in milliseconds) it takes to move |dir| from |state| to |nextState|.
+  static u64 ComputeMoveMillis(const Level* level, const State* state, const State* nextState, Direction dir);
+  // Plays |moves| from |initialState|, adding up their durations in |millis|. Returns true if every move is legal and the
+  // last one wins. Otherwise, |failedMove| (if given) is the index of the illegal move, or -1 if they just didn't win.
+  // Either way, the level is put back to |initialState| afterwards.
+  static bool ReplaySolution(Level* level, const State& initialState, const Vector<Direction>& moves, u64* millis, s32* failedMove = nullptr);
+  static bool WouldStephenStepOnGrill(const Level* level, Stephen stephen, Direction dir);
+  // Used as a tiebreaker between equally fast solutions, since backwards movements are easier to execute.
+  static bool IsBackwardsMovement(Direction facing, Direction dir);
+
+private:
+  void BFSStateGraph();
+  u64 GraphKey(const State& initialState) const;
+  bool LoadGraph();
+  // Throws away whatever LoadGraph got through, so that the BFS can start from scratch.
+  void ForgetGraph();
+  void SaveGraph();
+  State* GetOrInsertState(u16 depth, u32 parent, Direction dir);
+  // Builds _tightPruning, if the profile has any room left to tighten. Returns false if it doesn't.
+  bool TightenPruning(u16 depth);
+  // Roughly how many bytes the graph takes up so far: the state set (table and arena), the shallow states, and our lists of IDs.
+  size_t MemoryUsed() const;
+  void CheckMemoryBudget(u16 depth);
+
+#if PARENT_POINTERS
+  // Recomputes the result of |dir| from |state|, and finds it in the graph. Returns nullptr if the move is illegal.
+  State* GetSuccessor(const State* state, Direction dir);
+  // Walks parent IDs back from |winningState| to produce a move-optimal solution, which seeds DFSWinStates with a bound.
+  void SeedBestSolution(State* winningState);
+#else
+  void CreateShallowStates();
+#endif
+  void ComputeWinningStates();
+  // Where the goal distances live depends on how we're storing the graph. WinDistance is the distance to the goal
+  // we're currently solving for, which is what the timing search (and everything after it) follows.
+  u16& GoalDistance(State* state, Goal goal) const;
+  inline u16& WinDistance(State* state) const { return GoalDistance(state, _goal); }
+  // Called once for every state we add to the graph.
+  void InitGoalDistances(State* state);
+
+  // One depth-first search through the winning states. When we search in parallel, each worker gets its own.
+  struct TimingSearch {
+    Vector<Direction> solution;
+    Vector<Direction> bestSolution;
+    u64 bestMillis = (u64)-1;
+    u16 bestBackwardsMovements = 0;
+    u32 task = 0; // The task we're currently searching
+    u32 bestTask = 0; // The task which found bestSolution. Ties go to the earlier task, which is what a serial DFS would pick.
+  };
+
+  // A subtree of the DFS, rooted at |state|. The moves to get there are stored separately, in SplitTimingSearch's |moves|.
+  struct TimingTask {
+    State* state;
+    u64 totalMillis;
+    u16 backwardsMovements;
+    u32 movesStart;
+    u16 movesLength;
+  };
+
+  // Splits the top of the DFS into (at least) |minTasks| subtrees, in the same order that a serial DFS would visit them.
+  void SplitTimingSearch(State* initialState, s32 minTasks, Vector<TimingTask>& tasks, Vector<Direction>& moves);
+  void ParallelDFSWinStates(State* initialState, u32 threads);
+  void DFSWinStates(TimingSearch& search, State* state, u64 totalMillis, u16 backwardsMovements);
+  void ComputePenaltyAndRecurse(TimingSearch& search, State* state, State* nextState, Direction dir, u64 totalMillis, u16 backwardsMovements);
+
+  // The cheapest AlternativeCost from |state| to a winning state, only using moves which lead towards victory.
+  u64 RemainingCost(State* state, std::unordered_map<State*, u64>& memo);
+
+  Level* _level = nullptr;
+  Pruning _pruning;
+  const char* _graphPath = nullptr;
+  // Choose a relatively large initial size because we'll need it.
+#if FLAT_HASH_SET
+  StateSet _visitedNodes2 = StateSet(0x7FFFFF);
+#else
+  NodeHashSet<State> _visitedNodes2 = NodeHashSet<State>(0x7FFFFF);
+#endif
+  u16 _winningDepth = UNWINNABLE;
+
+  enum class MemoryStage : u8 {
+    Normal,
+    Tightened, // Expand every layer from the next one on with tighter pruning, so that the layers grow more slowly.
+    LastLayer, // Finish the layer we're building, so that the graph is still a complete BFS up to some depth, then stop.
+    Truncated, // Stop right away, and solve with whatever we have.
+  };
+  size_t _memoryBudget = 0;
+  bool _keepPruning = false;
+  MemoryStage _memoryStage = MemoryStage::Normal;
+  // The pruning for MemoryStage::Tightened, which only applies to states at _tightPruningDepth or deeper. The states before
+  // that were expanded with _pruning, and GetSuccessor has to agree with the BFS about which moves it took.
+  std::unique_ptr<Pruning> _tightPruning;
+  u16 _tightPruningDepth = UNWINNABLE;
+  inline Pruning& PruningFor(u16 depth) { return depth >= _tightPruningDepth ? *_tightPruning : _pruning; }
+  Goal _goal = WinGoal;
+  u16 _bestScore = 0; // The best Score of any state in the graph, which defines ScoreGoal
+  // The BFS frontier, as node IDs (indices into _explored). We alternate between the two buffers at each depth:
+  // one holds the layer we're currently expanding, the other collects the layer we'll expand next.
+  Vector<u32> _frontier[2];
+  // Every node we've inserted, in the order we found them (which, since we're a BFS, is sorted by depth).
+  Vector<State*> _explored;
+
+#if PARENT_POINTERS
+  u16 _expandedDepth = 0; // States deeper than this were never expanded, so they have no successors.
+  State* _firstWinningState = nullptr;
+#else
+  LinearAllocator _shallowAlloc;
+  LinkedLoop<ShallowState> _explored2;
+#endif
+
+  Vector<Direction> _bestSolution;
+  u64 _bestMillis = (u64)-1;
+  u16 _bestBackwardsMovements = 0;
+  // The best time any worker has found so far. Only used for pruning, so it's fine if a worker sees a stale value.
+  std::atomic<u64> _sharedBestMillis{(u64)-1};
+};
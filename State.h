@@ -1,51 +1,91 @@
-#pragma once
-#include "LevelData.h"
-#include "WitnessRNG/StdLib.h"
-
-// This is a shallow copy of the State struct -- it does not include positions of stephen nor the sausages
-// and is thus much smaller. Fortunately, we can determine the shortest path without knowledge of actual state.
-struct ShallowState {
-  ShallowState* next = nullptr;
-  ShallowState* u = nullptr;
-  ShallowState* d = nullptr;
-  ShallowState* l = nullptr;
-  ShallowState* r = nullptr;
-
-#define UNWINNABLE 0xFFFE
-  u16 winDistance = UNWINNABLE;
-};
-
-struct State {
-  Stephen stephen;
-
-#define o(x) +1
-  Sausage sausages[SAUSAGES];
-#undef o
-
-  // Used to build the tree, ergo not part of the hashing or comparison algos
-  State* next = nullptr;
-  State* u = nullptr;
-  State* d = nullptr;
-  State* l = nullptr;
-  State* r = nullptr;
-  ShallowState* shallow; // TODO: Consider the benefits of using shallow->l = (ShallowState*)state as a placeholder?
-
-#if HASH_CACHING
-  size_t hash = 0;
-#endif
-
-  bool operator==(const State& other) const;
-  size_t Hash() const;
-};
-
-namespace std {
-template<> struct hash<State> {
-  size_t operator()(const State& state) const {
-#if HASH_CACHING
-  return state.hash;
-#else
-  return state.Hash();
-#endif
-  }
-};
-}
+#pragma once
+#include "LevelData.h"
+#include "WitnessRNG/StdLib.h"
+
+#define UNWINNABLE 0xFFFE
+
+// The solver computes the distance to each of these in a single retrograde pass, so that it can fall back from one to the
+// next without rebuilding anything.
+enum Goal : u8 {
+  WinGoal,   // Level::Won
+  ScoreGoal, // The best Score of any explored state, for levels we can't win
+#if CUSTOM_GOAL
+  CustomGoal, // IsCustomGoal, in Solver.cpp
+#endif
+  GOAL_COUNT,
+};
+
+// This is a shallow copy of the State struct -- it does not include positions of stephen nor the sausages
+// and is thus much smaller. Fortunately, we can determine the shortest path without knowledge of actual state.
+struct ShallowState {
+  ShallowState* next = nullptr;
+  ShallowState* u = nullptr;
+  ShallowState* d = nullptr;
+  ShallowState* l = nullptr;
+  ShallowState* r = nullptr;
+
+  u16 goalDistance[GOAL_COUNT];
+
+  ShallowState() {
+    for (u16& distance : goalDistance) distance = UNWINNABLE;
+  }
+};
+
+struct State {
+  Stephen stephen;
+
+#if OVERWORLD_HACK
+  // The overworld has up to 33 sausages, but they never move -- they just get retired once you step on the exit tile.
+  // So rather than storing every sausage, we only store which ones are retired, and the handful (if any) which have
+  // moved from their starting position. Everything else is read from the level's initial layout.
+  u64 retired = 0;
+  u64 moved = 0;
+  Sausage active[ACTIVE_SAUSAGES]; // One entry per bit in |moved|, in order. Only the first popcount(moved) are meaningful.
+  static const Sausage* initialSausages; // Set by Level::GetState
+#else
+#define o(x) +1
+  Sausage sausages[SAUSAGES];
+#undef o
+#endif
+
+  // Used to build the tree, ergo not part of the hashing or comparison algos
+#if PARENT_POINTERS
+  // Rather than storing the edges, we only remember how we reached this state.
+  // Successors are recomputed (via Level::Move) whenever the solver needs them.
+  u32 parent = 0; // Index into Solver::_explored
+  u16 depth = 0;
+  u16 goalDistance[GOAL_COUNT]; // Set by the solver when the state is inserted
+  Direction move = None; // The move which took us from |parent| to this state
+#else
+  State* u = nullptr;
+  State* d = nullptr;
+  State* l = nullptr;
+  State* r = nullptr;
+  ShallowState* shallow; // TODO: Consider the benefits of using shallow->l = (ShallowState*)state as a placeholder?
+#endif
+
+#if HASH_CACHING
+  size_t hash = 0;
+#endif
+
+  bool operator==(const State& other) const;
+  size_t Hash() const;
+
+#if OVERWORLD_HACK
+  Sausage GetSausage(u8 i) const;
+#else
+  inline const Sausage& GetSausage(u8 i) const { return sausages[i]; }
+#endif
+};
+
+namespace std {
+template<> struct hash<State> {
+  size_t operator()(const State& state) const {
+#if HASH_CACHING
+  return state.hash;
+#else
+  return state.Hash();
+#endif
+  }
+};
+}
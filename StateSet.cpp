@@ -0,0 +1,189 @@
+#include "StateSet.h"
+#include "PageAllocator.h"
+#include <new>
+#include <chrono>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define USE_SSE2 1
+#else
+#define USE_SSE2 0
+#endif
+
+inline u32 CountTrailingZeros(u32 mask) {
+#if defined(_MSC_VER)
+  unsigned long index;
+  _BitScanForward(&index, mask);
+  return index;
+#else
+  return __builtin_ctz(mask);
+#endif
+}
+
+inline size_t HashOf(const State& state) {
+  return std::hash<State>()(state);
+}
+
+StateSet::StateSet(size_t initialSize) {
+  // Swiss tables are happy up to 7/8 full, so size for that.
+  size_t slots = initialSize + initialSize / 7;
+  _groups = 1;
+  while (_groups * GROUP_SIZE < slots) _groups *= 2;
+  _table = AllocateGroups(_groups);
+
+  // Each block should fill at least one page, otherwise huge pages would mostly go to waste.
+  while (((size_t)1 << _blockBits) * sizeof(State) < PageBytes()) _blockBits++;
+}
+
+StateSet::~StateSet() {
+  FreePages(_table, _groups * sizeof(Group));
+  for (State* block : _blocks) FreePages(block, ((size_t)1 << _blockBits) * sizeof(State));
+}
+
+StateSet::Group* StateSet::AllocateGroups(size_t count) {
+  Group* table = (Group*)AllocatePages(count * sizeof(Group));
+  for (size_t i=0; i<count; i++) memset(table[i].control, EMPTY, GROUP_SIZE);
+  return table;
+}
+
+u32 StateSet::MatchTag(const Group& group, u8 tag) {
+#if USE_SSE2
+  __m128i control = _mm_loadu_si128((const __m128i*)group.control);
+  return _mm_movemask_epi8(_mm_cmpeq_epi8(control, _mm_set1_epi8((char)tag)));
+#else
+  u32 mask = 0;
+  for (u32 i=0; i<GROUP_SIZE; i++) {
+    if (group.control[i] == tag) mask |= (1 << i);
+  }
+  return mask;
+#endif
+}
+
+u32 StateSet::MatchEmpty(const Group& group) {
+#if USE_SSE2
+  __m128i control = _mm_loadu_si128((const __m128i*)group.control);
+  return _mm_movemask_epi8(control); // Only EMPTY has the high bit set
+#else
+  return MatchTag(group, EMPTY);
+#endif
+}
+
+bool StateSet::CopyAdd(const State& state, State** result) {
+  return Add(HashOf(state), [&state](const State& candidate) { return candidate == state; },
+    [&state](State* slot) { new (slot) State(state); }, result);
+}
+
+bool StateSet::LevelAdd(const Level& level, State** result) {
+  return Add(level.Hash(), [&level](const State& candidate) { return level.Matches(candidate); },
+    [&level](State* slot) { new (slot) State(level.GetState()); }, result);
+}
+
+template<typename EqualsFn, typename ConstructFn>
+bool StateSet::Add(size_t hash, EqualsFn equals, ConstructFn construct, State** result) {
+  if (_size + 1 > _groups * GROUP_SIZE * 7 / 8) Grow();
+
+  u8 tag = hash & 0x7F;
+  // The low bits are the tag, so use the next ones to pick a group. Then probe groups in triangular order
+  // (+1, +2, +3, ...), which visits every group since the group count is a power of 2.
+  size_t g = (hash >> 7) & (_groups - 1);
+  for (size_t step = 1; ; step++) {
+    Group& group = _table[g];
+    for (u32 matches = MatchTag(group, tag); matches != 0; matches &= matches - 1) {
+      State* candidate = GetState(group.slots[CountTrailingZeros(matches)]);
+      if (equals(*candidate)) {
+        *result = candidate;
+        return false;
+      }
+    }
+
+    u32 empties = MatchEmpty(group);
+    if (empties != 0) {
+      u32 index = (u32)_size;
+      if ((index >> _blockBits) == (u32)_blocks.Size()) {
+        _blocks.Push((State*)AllocatePages(((size_t)1 << _blockBits) * sizeof(State)));
+      }
+      State* copy = GetState(index);
+      construct(copy);
+      u32 slot = CountTrailingZeros(empties);
+      group.control[slot] = tag;
+      group.slots[slot] = index;
+      _size++;
+      *result = copy;
+      return true;
+    }
+
+    g = (g + step) & (_groups - 1);
+  }
+}
+
+void StateSet::Grow() {
+  FreePages(_table, _groups * sizeof(Group));
+  _groups *= 2;
+  _table = AllocateGroups(_groups);
+
+  // Everything in the arena is unique, so we just need to find each one an empty slot.
+  for (u32 index=0; index<_size; index++) {
+    size_t hash = HashOf(*GetState(index));
+    size_t g = (hash >> 7) & (_groups - 1);
+    for (size_t step = 1; ; step++) {
+      u32 empties = MatchEmpty(_table[g]);
+      if (empties != 0) {
+        u32 slot = CountTrailingZeros(empties);
+        _table[g].control[slot] = hash & 0x7F;
+        _table[g].slots[slot] = index;
+        break;
+      }
+      g = (g + step) & (_groups - 1);
+    }
+  }
+}
+
+size_t StateSet::BytesUsed() const {
+  size_t table = _groups * sizeof(Group);
+  size_t arena = (size_t)_blocks.Size() * ((size_t)1 << _blockBits) * sizeof(State);
+  return table + arena;
+}
+
+void BenchmarkStateSets(const Vector<State*>& states) {
+  using namespace std::chrono;
+  printf("Benchmarking hash sets with %d states (sizeof(State) = %zd)\n", states.Size(), sizeof(State));
+  State* result;
+
+  {
+    // NodeHashSet allocates each node (and its buckets) with new, so the only way to see what it really costs is to ask the OS.
+    // This runs first, so that the heap hasn't got any freed memory lying around to hide the growth.
+    size_t residentBefore = ResidentBytes();
+    NodeHashSet<State>* set = new NodeHashSet<State>(0x7FFFFF);
+    auto start = high_resolution_clock::now();
+    for (State* state : states) set->CopyAdd(*state, &result);
+    auto middle = high_resolution_clock::now();
+    size_t residentAfter = ResidentBytes();
+    for (State* state : states) set->CopyAdd(*state, &result);
+    auto end = high_resolution_clock::now();
+    double insertSeconds = duration<double>(middle - start).count();
+    double findSeconds = duration<double>(end - middle).count();
+    printf("NodeHashSet: %.1f M inserts/s, %.1f M finds/s, ", states.Size() / insertSeconds / 1e6, states.Size() / findSeconds / 1e6);
+    if (residentBefore == 0 || residentAfter < residentBefore) {
+      printf("%zd bytes per state plus a node allocation (couldn't measure)\n", sizeof(State));
+    } else {
+      printf("%.1f bytes per state (measured)\n", (double)(residentAfter - residentBefore) / states.Size());
+    }
+    delete set;
+  }
+
+  {
+    StateSet* set = new StateSet(0x7FFFFF);
+    auto start = high_resolution_clock::now();
+    for (State* state : states) set->CopyAdd(*state, &result);
+    auto middle = high_resolution_clock::now();
+    for (State* state : states) set->CopyAdd(*state, &result);
+    auto end = high_resolution_clock::now();
+    double insertSeconds = duration<double>(middle - start).count();
+    double findSeconds = duration<double>(end - middle).count();
+    printf("StateSet:    %.1f M inserts/s, %.1f M finds/s, %.1f bytes per state (including empty slots)\n",
+      states.Size() / insertSeconds / 1e6, states.Size() / findSeconds / 1e6, (double)set->BytesUsed() / set->Size());
+    delete set;
+  }
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include "Level.h"
+#include "State.h"
+#include "WitnessRNG/StdLib.h"
+
+// A flat (open addressing) hash set of States, in the style of abseil's swiss tables.
+// NodeHashSet allocates each entry separately, so every probe chases a pointer. Here, the table is just one control byte
+// per slot (7 bits of the hash, or EMPTY) plus a u32 index into the state arena, and we check 16 control bytes at once.
+// Unlike abseil, the indices live right next to their control bytes, so a lookup only misses the cache once in the table.
+// The arena is a list of fixed-size blocks which never move, so State pointers into the set stay valid as it grows.
+// Both the table and the arena come from AllocatePages, so they follow the MemoryPolicy (huge pages, NUMA).
+class StateSet {
+public:
+  StateSet(size_t initialSize);
+  ~StateSet();
+
+  // Same contract as NodeHashSet::CopyAdd: returns true if |state| was not in the set (and copies it in).
+  // Either way, |result| is set to the set's copy.
+  bool CopyAdd(const State& state, State** result);
+  // Same, but for the state that |level| is in. Duplicates are found without building a State at all,
+  // and new states are built straight into the arena.
+  bool LevelAdd(const Level& level, State** result);
+  inline size_t Size() const { return _size; }
+  size_t BytesUsed() const;
+
+private:
+  static constexpr u8 EMPTY = 0x80; // Tags are only 7 bits, so the high bit means empty. There are no deletes (or tombstones).
+  static constexpr size_t GROUP_SIZE = 16;
+  static constexpr u32 MIN_BLOCK_BITS = 16; // At least 64k States per arena block (more if the pages are bigger)
+
+  struct Group {
+    u8 control[GROUP_SIZE];
+    u32 slots[GROUP_SIZE]; // Indices into the arena
+  };
+
+  // The probe behind both of the above. |equals| compares against a candidate in the set, |construct| builds the new state in place.
+  template<typename EqualsFn, typename ConstructFn>
+  bool Add(size_t hash, EqualsFn equals, ConstructFn construct, State** result);
+  inline State* GetState(u32 index) const { return &_blocks[index >> _blockBits][index & ((1 << _blockBits) - 1)]; }
+  // Returns a bitmask of the slots in |group| whose control byte is |tag|.
+  static u32 MatchTag(const Group& group, u8 tag);
+  static u32 MatchEmpty(const Group& group);
+  Group* AllocateGroups(size_t count);
+  void Grow();
+
+  Group* _table = nullptr;
+  size_t _groups = 0; // Always a power of 2
+  size_t _size = 0;
+  u32 _blockBits = MIN_BLOCK_BITS;
+  Vector<State*> _blocks;
+};
+
+// Inserts and then re-finds every state in |states| with both NodeHashSet and StateSet, and prints the throughput and memory.
+void BenchmarkStateSets(const Vector<State*>& states);
@@ -1,17 +1,17 @@
-#pragma once
-using u8 = unsigned char;
-using s8 = signed char;
-using u16 = unsigned short;
-using s16 = short;
-using u32 = unsigned int;
-using s32 = int;
-using u64 = unsigned long long;
-using s64 = long long;
-static_assert(sizeof(u8) == 1);
-static_assert(sizeof(s8) == 1);
-static_assert(sizeof(u16) == 2);
-static_assert(sizeof(s16) == 2);
-static_assert(sizeof(u32) == 4);
-static_assert(sizeof(s32) == 4);
-static_assert(sizeof(u64) == 8);
-static_assert(sizeof(s64) == 8);
+#pragma once
+using u8 = unsigned char;
+using s8 = signed char;
+using u16 = unsigned short;
+using s16 = short;
+using u32 = unsigned int;
+using s32 = int;
+using u64 = unsigned long long;
+using s64 = long long;
+static_assert(sizeof(u8) == 1);
+static_assert(sizeof(s8) == 1);
+static_assert(sizeof(u16) == 2);
+static_assert(sizeof(s16) == 2);
+static_assert(sizeof(u32) == 4);
+static_assert(sizeof(s32) == 4);
+static_assert(sizeof(u64) == 8);
+static_assert(sizeof(s64) == 8);
@@ -0,0 +1,168 @@
+#include "Validator.h"
+#include "Solver.h"
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <unordered_map>
+
+Validator::Validator(Level** levels, s32 levelCount) {
+  _levels = levels;
+  _levelCount = levelCount;
+}
+
+void Validator::AddPath(const std::string& path) {
+  std::filesystem::path fsPath(path);
+  if (std::filesystem::is_directory(fsPath)) {
+    // Sorted, so that the report is in the same order on every machine.
+    std::vector<std::string> files;
+    for (const auto& entry : std::filesystem::directory_iterator(fsPath)) {
+      if (entry.path().extension() == ".dem") files.push_back(entry.path().string());
+    }
+    std::sort(files.begin(), files.end());
+    for (const std::string& file : files) AddPath(file);
+    return;
+  }
+
+  Demo demo;
+  demo.path = path;
+  // main names the file after the first word of the level name (plus " #2" and so on for alternative solutions)
+  std::string stem = fsPath.stem().string();
+  stem = stem.substr(0, stem.find_first_of(' '));
+  for (s32 i=0; i<_levelCount; i++) {
+    std::string levelName(_levels[i]->name);
+    if (levelName.substr(0, levelName.find_first_of(' ')) == stem) {
+      demo.level = _levels[i];
+      break;
+    }
+  }
+  if (demo.level == nullptr) demo.status = NoLevel;
+  _demos.push_back(demo);
+}
+
+bool Validator::LoadBaseline(const std::string& path) {
+  std::ifstream file(path);
+  if (!file.is_open()) return false;
+
+  // Each line is "<status> <millis> <path>", the path goes last since it might have spaces.
+  std::unordered_map<std::string, u64> baseline;
+  std::string status;
+  u64 millis;
+  std::string demoPath;
+  while (file >> status >> millis) {
+    std::getline(file >> std::ws, demoPath);
+    if (status == "ok") baseline[demoPath] = millis;
+  }
+
+  for (Demo& demo : _demos) {
+    auto it = baseline.find(demo.path);
+    if (it != baseline.end()) demo.baselineMillis = it->second;
+  }
+  return true;
+}
+
+s32 Validator::Run(u32 threads) {
+  // Group the files by level. Replaying a file moves the level around, so one level can only be used by one thread at a time.
+  std::vector<Level*> levels;
+  std::unordered_map<Level*, std::vector<Demo*>> demosByLevel;
+  for (Demo& demo : _demos) {
+    if (demo.level == nullptr) continue;
+    if (demosByLevel.find(demo.level) == demosByLevel.end()) levels.push_back(demo.level);
+    demosByLevel[demo.level].push_back(&demo);
+  }
+
+  std::atomic<u32> nextTask{0};
+  auto worker = [&]() {
+    while (true) {
+      u32 task = nextTask++;
+      if (task >= levels.size()) break;
+      for (Demo* demo : demosByLevel[levels[task]]) Replay(*demo);
+    }
+  };
+
+  if (threads < 1) threads = 1;
+  if (threads > levels.size()) threads = (u32)levels.size();
+#if OVERWORLD_HACK
+  threads = 1; // States find their initial sausages through a global which Level::GetState sets, so only one level at a time
+#endif
+  if (threads <= 1) {
+    worker();
+  } else {
+    std::vector<std::thread> pool;
+    for (u32 i=0; i<threads; i++) pool.emplace_back(worker);
+    for (std::thread& thread : pool) thread.join();
+  }
+
+  s32 failures = 0;
+  s32 slower = 0;
+  for (const Demo& demo : _demos) {
+    const char* path = demo.path.c_str();
+    switch (demo.status) {
+      case Passed:
+        if (demo.baselineMillis != 0 && demo.millis > demo.baselineMillis) {
+          printf("SLOWER  %s takes %lld.%03lld seconds (was %lld.%03lld)\n", path,
+            demo.millis / 1000, demo.millis % 1000, demo.baselineMillis / 1000, demo.baselineMillis % 1000);
+          slower++;
+        } else {
+          printf("ok      %s takes %lld.%03lld seconds\n", path, demo.millis / 1000, demo.millis % 1000);
+        }
+        continue;
+      case NoLevel:     printf("FAILED  %s does not match any level\n", path); break;
+      case Unsupported: printf("FAILED  %s is for %s, which has the wrong number of sausages for this build\n", path, demo.level->name); break;
+      case Unreadable:  printf("FAILED  %s could not be read\n", path); break;
+      case IllegalMove: printf("FAILED  %s has an illegal move (move %d)\n", path, demo.failedMove + 1); break;
+      case NotWon:      printf("FAILED  %s does not win %s\n", path, demo.level->name); break;
+    }
+    failures++;
+  }
+
+  printf("Validated %zd solutions: %d failed, %d got slower\n", _demos.size(), failures, slower);
+  return failures;
+}
+
+void Validator::WriteReport(const std::string& path) const {
+  std::ofstream file(path);
+  for (const Demo& demo : _demos) {
+    file << (demo.status == Passed ? "ok" : "failed") << ' ' << demo.millis << ' ' << demo.path << '\n';
+  }
+}
+
+void Validator::Replay(Demo& demo) {
+  Level* level = demo.level;
+#if !OVERWORLD_HACK
+#define o(x) +1
+  if (level->SausageCount() != SAUSAGES) {
+#undef o
+    demo.status = Unsupported;
+    return;
+  }
+#endif
+
+  std::ifstream file(demo.path);
+  if (!file.is_open()) {
+    demo.status = Unreadable;
+    return;
+  }
+
+  Vector<Direction> solution;
+  std::string line;
+  while (std::getline(file, line)) {
+    if (!line.empty() && line.back() == '\r') line.pop_back();
+    if (line.empty()) continue;
+    Direction dir = None;
+    for (Direction candidate : {Up, Down, Left, Right}) {
+      if (line == DEM_DIRS[candidate]) dir = candidate;
+    }
+    if (dir == None) {
+      demo.status = Unreadable;
+      return;
+    }
+    solution.Push(dir);
+  }
+
+  State initialState = level->GetState();
+  if (!Solver::ReplaySolution(level, initialState, solution, &demo.millis, &demo.failedMove)) {
+    demo.status = (demo.failedMove >= 0 ? IllegalMove : NotWon);
+  }
+}
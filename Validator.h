@@ -0,0 +1,46 @@
+#pragma once
+#include "Level.h"
+#include <string>
+#include <vector>
+
+// Replays .dem files (as written by main) against their levels, to make sure that old solutions still work after engine changes.
+// Each file is matched to a level by name (e.g. "1-1.dem" is "1-1 Lachrymose Head"), replayed from the level's initial state,
+// and re-timed with the same cost model as Solver::ComputePenaltyAndRecurse.
+struct Validator {
+  Validator(Level** levels, s32 levelCount);
+
+  // Adds a single .dem file, or every .dem file in a directory.
+  void AddPath(const std::string& path);
+  // Loads the report from a previous run, so that we can flag solutions which got slower.
+  bool LoadBaseline(const std::string& path);
+
+  // Replays every file, one level per task (since replaying moves the level around). Returns the number of failures.
+  s32 Run(u32 threads);
+  // Writes one line per file, in the same format that LoadBaseline reads.
+  void WriteReport(const std::string& path) const;
+
+private:
+  enum Status : u8 {
+    Passed,
+    NoLevel, // We couldn't find a level with this name
+    Unsupported, // The level doesn't fit into State (i.e. it has the wrong number of sausages for this build)
+    Unreadable,
+    IllegalMove,
+    NotWon,
+  };
+
+  struct Demo {
+    std::string path;
+    Level* level = nullptr;
+    Status status = Passed;
+    s32 failedMove = -1; // For IllegalMove, the index of the move which failed
+    u64 millis = 0;
+    u64 baselineMillis = 0; // 0 if there's no baseline for this file
+  };
+
+  void Replay(Demo& demo);
+
+  Level** _levels;
+  s32 _levelCount;
+  std::vector<Demo> _demos;
+};
@@ -0,0 +1,84 @@
+# Builds the solver as Release, LTO, PGO, and LTO+PGO (each in its own directory under BENCHMARK_DIR), then times each one
+# on the training levels and reports the speedup over Release. Also checks that they all find the same solutions.
+# Called by the benchmark target, with SOURCE_DIR, BENCHMARK_DIR, GENERATOR, CXX_COMPILER, CXX_FLAGS, and LEVELS (comma separated).
+cmake_minimum_required(VERSION 3.23) # For fractional seconds in string(TIMESTAMP)
+
+string(REPLACE "," ";" LEVELS "${LEVELS}")
+
+function(build_solver dir)
+  execute_process(
+    COMMAND ${CMAKE_COMMAND} -S ${SOURCE_DIR} -B ${dir} -G ${GENERATOR}
+      -DCMAKE_BUILD_TYPE=Release -DCMAKE_CXX_COMPILER=${CXX_COMPILER} -DCMAKE_CXX_FLAGS=${CXX_FLAGS}
+      "-DSSR_TRAINING_LEVELS=${LEVELS}" ${ARGN}
+    OUTPUT_QUIET
+    RESULT_VARIABLE result)
+  if(NOT result EQUAL 0)
+    message(FATAL_ERROR "Configuring ${dir} failed")
+  endif()
+  execute_process(COMMAND ${CMAKE_COMMAND} --build ${dir} --target SSRBruteForce --parallel OUTPUT_QUIET RESULT_VARIABLE result)
+  if(NOT result EQUAL 0)
+    message(FATAL_ERROR "Building ${dir} failed")
+  endif()
+endfunction()
+
+# PGO builds are built twice in the same directory, since GCC looks up profiles by object path.
+function(build_pgo_solver dir)
+  build_solver(${dir} -DSSR_PGO=GENERATE ${ARGN})
+  execute_process(COMMAND ${CMAKE_COMMAND} --build ${dir} --target pgo-train OUTPUT_QUIET RESULT_VARIABLE result)
+  if(NOT result EQUAL 0)
+    message(FATAL_ERROR "Training ${dir} failed")
+  endif()
+  build_solver(${dir} -DSSR_PGO=USE ${ARGN})
+endfunction()
+
+# Sets |millisVar| to the total time across all levels. The solutions are kept in dir/runs.
+function(time_solver dir millisVar)
+  file(REMOVE_RECURSE ${dir}/runs)
+  file(MAKE_DIRECTORY ${dir}/runs)
+  set(total 0)
+  foreach(level IN LISTS LEVELS)
+    string(TIMESTAMP start "%s%f" UTC)
+    execute_process(
+      COMMAND ${dir}/SSRBruteForce --level=${level} --batch
+      WORKING_DIRECTORY ${dir}/runs
+      OUTPUT_QUIET
+      RESULT_VARIABLE result)
+    string(TIMESTAMP end "%s%f" UTC)
+    if(NOT result EQUAL 0)
+      message(FATAL_ERROR "${dir} failed on level ${level} (${result})")
+    endif()
+    math(EXPR millis "(${end} - ${start}) / 1000")
+    math(EXPR total "${total} + ${millis}")
+  endforeach()
+  set(${millisVar} ${total} PARENT_SCOPE)
+endfunction()
+
+message(STATUS "Building...")
+build_solver(${BENCHMARK_DIR}/release)
+build_solver(${BENCHMARK_DIR}/lto -DSSR_LTO=ON)
+build_pgo_solver(${BENCHMARK_DIR}/pgo)
+build_pgo_solver(${BENCHMARK_DIR}/lto-pgo -DSSR_LTO=ON)
+
+message(STATUS "Solving levels ${LEVELS}")
+time_solver(${BENCHMARK_DIR}/release releaseMillis)
+message(STATUS "release: ${releaseMillis} ms")
+foreach(config lto pgo lto-pgo)
+  time_solver(${BENCHMARK_DIR}/${config} millis)
+  # Fixed point, since math() only does integers.
+  math(EXPR speedup "${releaseMillis} * 100 / ${millis}")
+  math(EXPR whole "${speedup} / 100")
+  math(EXPR fraction "${speedup} % 100")
+  if(fraction LESS 10)
+    set(fraction "0${fraction}")
+  endif()
+  message(STATUS "${config}: ${millis} ms (${whole}.${fraction}x)")
+
+  file(GLOB solutions RELATIVE ${BENCHMARK_DIR}/release/runs ${BENCHMARK_DIR}/release/runs/*.dem)
+  foreach(solution IN LISTS solutions)
+    file(READ ${BENCHMARK_DIR}/release/runs/${solution} expected)
+    file(READ ${BENCHMARK_DIR}/${config}/runs/${solution} actual)
+    if(NOT expected STREQUAL actual)
+      message(WARNING "${config} found a different solution in ${solution} than release")
+    endif()
+  endforeach()
+endforeach()
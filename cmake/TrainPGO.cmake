@@ -0,0 +1,30 @@
+# Runs the instrumented solver on each training level, and merges the profiles if we're using Clang.
+# Called by the pgo-train target, with SOLVER, LEVELS (comma separated), PGO_DIR, and (for Clang) LLVM_PROFDATA.
+
+string(REPLACE "," ";" LEVELS "${LEVELS}")
+file(MAKE_DIRECTORY ${PGO_DIR}/runs) # The solver writes its .dem files to the working directory
+foreach(level IN LISTS LEVELS)
+  message(STATUS "Training on level ${level}")
+  execute_process(
+    COMMAND ${SOLVER} --level=${level} --batch
+    WORKING_DIRECTORY ${PGO_DIR}/runs
+    OUTPUT_QUIET
+    RESULT_VARIABLE result)
+  if(NOT result EQUAL 0)
+    message(FATAL_ERROR "Training on level ${level} failed (${result})")
+  endif()
+endforeach()
+
+file(GLOB rawProfiles ${PGO_DIR}/*.profraw)
+if(rawProfiles)
+  if(NOT LLVM_PROFDATA)
+    message(FATAL_ERROR "Clang PGO needs llvm-profdata to merge the profiles, but it wasn't found")
+  endif()
+  execute_process(
+    COMMAND ${LLVM_PROFDATA} merge -output=${PGO_DIR}/default.profdata ${rawProfiles}
+    RESULT_VARIABLE result)
+  if(NOT result EQUAL 0)
+    message(FATAL_ERROR "llvm-profdata merge failed (${result})")
+  endif()
+  file(REMOVE ${rawProfiles})
+endif()